@@ -0,0 +1,63 @@
+/*      ____ ______ ______  ____
+       /  _//\  __//\  __ \/\_, \
+ ____ /\  __ \\___  \\ \/\ \//  /__ ___________________________________________
+|     \ \_____\\____/ \_____\\_____\                                           |
+|  MOS \/_____//___/ \/_____//_____/ CPU Emulator - Farm                       |
+|  Copyright (C) 1999-2025 Manuel Sainz de Baranda y Goñi.                     |
+|                                                                              |
+|  This emulator is free software: you can redistribute it and/or modify it    |
+|  under the terms of the GNU Lesser General Public License as published by    |
+|  the Free Software Foundation, either version 3 of the License, or (at your  |
+|  option) any later version.                                                  |
+|                                                                              |
+|  This emulator is distributed in the hope that it will be useful, but        |
+|  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY  |
+|  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public      |
+|  License for more details.                                                   |
+|                                                                              |
+|  You should have received a copy of the GNU Lesser General Public License    |
+|  along with this emulator. If not, see <http://www.gnu.org/licenses/>.       |
+|                                                                              |
+'=============================================================================*/
+
+#ifndef _emulation_CPU_6502_farm_H_
+#define _emulation_CPU_6502_farm_H_
+
+#ifdef CPU_6502_USE_LOCAL_HEADER
+#	include "6502.h"
+#else
+#	include <emulation/CPU/6502.h>
+#endif
+
+Z_C_SYMBOLS_BEGIN
+
+/** Runs several independent CPUs, each one with its own cycle budget, in
+  * time slices on a pool of threads.
+  * @details Each thread owns a queue of CPUs, which it runs in turn for up
+  * to @p slice cycles each, so that a CPU stays on the same thread from one
+  * slice to the next. A thread whose queue is empty steals the CPU that has
+  * waited the longest in the queue of another thread. The calling thread is
+  * one of the workers, and the function returns when every CPU has consumed
+  * its budget. A CPU whose breakpoints stop the execution is not run again
+  * and keeps the rest of its budget.
+  * @param objects An array of 6502 emulator instances. Different instances
+  * can run at the same time, so they must not share callbacks or memory
+  * that are not thread-safe.
+  * @param budgets An array with the number of cycles to be executed by each
+  * CPU. The function decrements its elements as cycles are executed.
+  * @param count The number of elements in @p objects and @p budgets.
+  * @param slice The maximum number of cycles to be executed by a CPU each
+  * time it is run, or @c 0 to run it until its budget is consumed.
+  * @param threads The number of threads, including the calling one.
+  * @param context The value passed as the first argument to @p completed.
+  * @param completed Callback called when a CPU consumes its budget or is
+  * stopped by a breakpoint, or @c NULL. It receives @p context and a
+  * pointer to the CPU, and can be called from any thread of the pool at
+  * the same time as other calls.
+  * @return @c TRUE on success; @c FALSE if there is not enough memory. */
+
+CPU_6502_API zboolean m6502_farm_run(M6502 *objects, zusize *budgets, zusize count, zusize slice, zuint threads, void *context, void (* completed)(void *context, M6502 *object));
+
+Z_C_SYMBOLS_END
+
+#endif /* _emulation_CPU_6502_farm_H_ */
@@ -0,0 +1,955 @@
+/*      ____ ______ ______  ____
+       /  _//\  __//\  __ \/\_, \
+ ____ /\  __ \\___  \\ \/\ \//  /__ ___________________________________________
+|     \ \_____\\____/ \_____\\_____\                                           |
+|  MOS \/_____//___/ \/_____//_____/ CPU Emulator                              |
+|  Copyright (C) 1999-2025 Manuel Sainz de Baranda y Goñi.                     |
+|                                                                              |
+|  This emulator is free software: you can redistribute it and/or modify it    |
+|  under the terms of the GNU Lesser General Public License as published by    |
+|  the Free Software Foundation, either version 3 of the License, or (at your  |
+|  option) any later version.                                                  |
+|                                                                              |
+|  This emulator is distributed in the hope that it will be useful, but        |
+|  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY  |
+|  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public      |
+|  License for more details.                                                   |
+|                                                                              |
+|  You should have received a copy of the GNU Lesser General Public License    |
+|  along with this emulator. If not, see <http://www.gnu.org/licenses/>.       |
+|                                                                              |
+'=============================================================================*/
+
+
+/*---------------------------------------------------------------------------.
+| Instruction semantics shared by `6502.c` and the C++ front end declared in |
+| `6502.hpp`. This header is not meant to be included by the user. All of it |
+| consists of macros written in terms of `object`, which must point to the   |
+| M6502 being emulated, and of READ_8, WRITE_8, READ_16, PUSH_16, POP_16,    |
+| DONE and EXTRA_CYCLE, which must be defined by the includer. Including it  |
+| again with CPU_6502_SEMANTICS_UNDEFINE defined removes its definitions.    |
+'---------------------------------------------------------------------------*/
+
+#ifndef CPU_6502_SEMANTICS_UNDEFINE
+
+/* MARK: - Macros: Registers */
+
+#define REGISTERS object->state
+
+#define PC REGISTERS.Z_6502_STATE_MEMBER_PC
+#define S  REGISTERS.Z_6502_STATE_MEMBER_S
+#define P  REGISTERS.Z_6502_STATE_MEMBER_P
+#define A  REGISTERS.Z_6502_STATE_MEMBER_A
+#define X  REGISTERS.Z_6502_STATE_MEMBER_X
+#define Y  REGISTERS.Z_6502_STATE_MEMBER_Y
+
+
+/* MARK: - Macros: Internal Bits */
+
+#define NMI	object->state.Z_6502_STATE_MEMBER_NMI
+#define IRQ	object->state.Z_6502_STATE_MEMBER_IRQ
+#define PENDING object->interrupt_pending
+
+#ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+#	define JAMMED object->jammed
+#else
+#	define JAMMED FALSE
+#endif
+
+
+/* MARK: - Macros: Temporal Data */
+
+#define CYCLES	  object->cycles
+#define OPCODE	  object->opcode
+#define EA	  object->ea
+#define EA_CYCLES object->ea_cycles
+
+
+/* MARK: - Macros: Flags */
+
+#define NP 128
+#define VP  64
+#define BP  16
+#define DP   8
+#define IP   4
+#define ZP   2
+#define CP   1
+
+#define NZP  (NP | ZP)
+#define NZCP (NP | ZP | CP)
+
+#define ZP_ZERO( value) (!(value) << 1)
+
+#ifdef CPU_6502_WITH_LAZY_FLAGS
+
+	/*-----------------------------------------------------------------.
+	| With lazy flags, the N and Z bits of P are not updated by the	   |
+	| instructions. Instead, NZ keeps a value from which they can be   |
+	| derived when needed: Z is set if its low byte is 0, and N is the |
+	| OR of its bits 7 and 8. Bit 8 allows N to be set along with Z.   |
+	'-----------------------------------------------------------------*/
+
+#	define NZ	      object->lazy_nz
+#	define N_FLAG	      ((NZ | NZ >> 1) & NP)
+#	define Z_FLAG	      ZP_ZERO(NZ & 0xFF)
+#	define MATERIALIZED_P (zuint8)((P & ~NZP) | N_FLAG | Z_FLAG)
+#	define P_FROM_NZ      P = MATERIALIZED_P;
+#	define NZ_FROM_P      NZ = (zuint16)(((P & ZP) ^ ZP) >> 1 | (P & NP) << 1);
+#	define FLAG(mask)     ((mask) == NP ? N_FLAG : (mask) == ZP ? Z_FLAG : P & (mask))
+
+#	define SET_P_NZ(value) NZ = (value)
+
+#	define SET_P_NZC(value, carry) \
+		(P = (zuint8)((P & ~CP) | (carry)), NZ = (value))
+
+#	define SET_P_N_Z(negative, zero) \
+		NZ = (zuint16)(((zero) != 0) | ((negative) & NP) << 1)
+
+#	define SET_P_Z(zero) NZ = (zuint16)(((zero) != 0) | N_FLAG << 1)
+
+#else
+#	define MATERIALIZED_P P
+#	define P_FROM_NZ
+#	define NZ_FROM_P
+#	define FLAG(mask) (P & (mask))
+
+#	define SET_P_NZ(value) P = (P & ~NZP) | ((value) ? ((value) & NP) : ZP)
+
+#	define SET_P_NZC(value, carry) \
+		P = (zuint8)((P & ~NZCP) | ((value) & NP) | ZP_ZERO(value) | (carry))
+
+#	define SET_P_N_Z(negative, zero) \
+		P = (zuint8)((P & ~NZP) | ((negative) & NP) | ZP_ZERO(zero))
+
+#	define SET_P_Z(zero) P = (P & ~ZP) | ZP_ZERO(zero)
+#endif
+
+
+/* MARK: - Macros: Variant */
+
+/*------------------------------------------------------------------.
+| The 2A03 has the decimal mode disabled: D can be set and pushed,  |
+| but adc and sbc ignore it. The 65C02 sets N and Z from the BCD    |
+| result, takes one extra cycle for it, and clears D when accepting |
+| an interrupt or executing brk.				    |
+'------------------------------------------------------------------*/
+
+#ifdef CPU_6502_VARIANT_2A03
+#	define DECIMAL_MODE FALSE
+#else
+#	define DECIMAL_MODE (P & DP)
+#endif
+
+#ifdef CPU_6502_VARIANT_65C02
+#	define DECIMAL_NZ		  SET_P_NZ(A);
+#	define DECIMAL_CYCLE		  EXTRA_CYCLE
+#	define CLEAR_DECIMAL_ON_INTERRUPT P &= ~DP;
+#	define JMP_IND_CYCLES		  6
+#else
+#	define DECIMAL_NZ
+#	define DECIMAL_CYCLE
+#	define CLEAR_DECIMAL_ON_INTERRUPT
+#	define JMP_IND_CYCLES		  5
+#endif
+
+
+/* MARK: - Macros: Stack */
+
+#define PUSH_8(value) WRITE_8(Z_6502_ADDRESS_STACK + S--, value);
+#define POP_8	      READ_8 (Z_6502_ADDRESS_STACK + ++S)
+
+
+/* MARK: - Macros: Addressing */
+
+#define BYTE_OPERAND	  READ_8 (PC + 1)
+#define WORD_OPERAND	  READ_16(PC + 1)
+#define READ_BYTE_OPERAND READ_8 ((PC += 2) - 1)
+#define READ_WORD_OPERAND READ_16((PC += 3) - 2)
+
+#define READ_POINTER(pointer_name) READ_16(Z_6502_ADDRESS_##pointer_name##_POINTER)
+
+#define   ZERO_PAGE_ADDRESS READ_BYTE_OPERAND
+#define ZERO_PAGE_X_ADDRESS (zuint8)(READ_BYTE_OPERAND + X)
+#define ZERO_PAGE_Y_ADDRESS (zuint8)(READ_BYTE_OPERAND + Y)
+#define    ABSOLUTE_ADDRESS READ_WORD_OPERAND
+#define  ABSOLUTE_X_ADDRESS READ_WORD_OPERAND + X
+#define  ABSOLUTE_Y_ADDRESS READ_WORD_OPERAND + Y
+#define  INDIRECT_X_ADDRESS READ_16((zuint8)(READ_BYTE_OPERAND + X))
+#define  INDIRECT_Y_ADDRESS READ_16(READ_BYTE_OPERAND) + Y
+#define INDIRECT_ZP_ADDRESS READ_16(READ_BYTE_OPERAND)
+
+
+/* MARK: - Macros: Reusable Code */
+
+#define COMPARE(register, value)						  \
+	{									  \
+	zuint8 v = value;							  \
+	zuint8 result = register - v;						  \
+										  \
+	SET_P_NZC								  \
+		(result,	       /* NP = result.7, ZP = 1 if result = 0  */ \
+		 !!(register >= v));   /* CP = 1 if register >= v, else CP = 0 */ \
+	}
+
+
+#define BRANCH(condition, cycles)			\
+	if (condition)					\
+		{					\
+		zuint16 pc = PC + 2;			\
+		zsint8 offset = (zsint8)BYTE_OPERAND;	\
+		zuint16 t = (zuint16)(pc + offset);	\
+							\
+		cycles = t >> 8 == pc >> 8 ? 3 : 4;	\
+		PC = t;					\
+		}					\
+							\
+	else	{					\
+		cycles = 2;				\
+		PC += 2;				\
+		}
+
+
+#define BRANCH_IF_CLEAR(flag_mask, cycles) BRANCH(!FLAG(flag_mask), cycles)
+#define BRANCH_IF_SET(  flag_mask, cycles) BRANCH( FLAG(flag_mask), cycles)
+
+
+#define BIT(read)								\
+	{									\
+	zuint8 v = read;							\
+										\
+	P = (P & ~VP) | (v & VP); /* TODO: Check if this is correct. */		\
+	SET_P_N_Z(v, v & A);							\
+	}
+
+
+#define COMPUTE_ADC_DECIMAL(v, c)				\
+	{							\
+	zuint l = (zuint)(A & 0x0F) + (v & 0x0F) + c;		\
+	zuint h = (zuint)(A & 0xF0) + (v & 0xF0);		\
+								\
+	P &= ~(VP | CP | NP | ZP);				\
+								\
+	if (!((l + h) & 0xFF))	       P |= ZP;			\
+	if (l > 0x09)		       {h += 0x10; l += 0x06;}	\
+	if (h & 0x80)		       P |= NP;			\
+	if (~(A ^ v) & (A ^ h) & 0x80) P |= VP;			\
+	if (h > 0x90)		       h += 0x60;		\
+	if (h >> 8)		       P |= CP;			\
+								\
+	A = (l & 0x0F) | (h & 0xF0);				\
+	NZ_FROM_P						\
+	DECIMAL_NZ						\
+	}
+
+
+#define COMPUTE_SBC_DECIMAL(v, c, t)			\
+	{						\
+	zuint l = (zuint)(A & 0x0F) - (v & 0x0F) - c;	\
+	zuint h = (zuint)(A & 0xF0) - (v & 0xF0);	\
+							\
+	P &= ~(VP | CP | ZP | NP);			\
+							\
+	if (l & 0x10)		      {l -= 6; h--;}	\
+	if ((A ^ v) & (A ^ t) & 0x80) P |= VP;		\
+	if (!(t >> 8))		      P |= CP;		\
+	if (!(t << 8))		      P |= ZP;		\
+	if (t & 0x80)		      P |= NP;		\
+	if (h & 0x0100)		      h -= 0x60;	\
+							\
+	A = (l & 0x0F) | (h & 0xF0);			\
+	NZ_FROM_P					\
+	DECIMAL_NZ					\
+	}
+
+
+#ifdef CPU_6502_WITH_DECIMAL_TABLES
+
+	/*------------------------------------------------------------------.
+	| The decimal mode results are taken from the tables built by	    |
+	| m6502_build_decimal_tables, which are indexed by the C flag, the  |
+	| accumulator and the operand. Each element holds the result in its |
+	| low byte and the N, V, Z and C flags in its high byte.	    |
+	'------------------------------------------------------------------*/
+
+#	define LOOKUP_DECIMAL(table, v, carry)				\
+		{							\
+		zuint16 r = object->decimal_tables->table[carry][A][v]; \
+									\
+		A = (zuint8)r;						\
+		P = (zuint8)((P & ~(NZCP | VP)) | (r >> 8));		\
+		NZ_FROM_P						\
+		}
+
+#	define ADC_DECIMAL(v, c)    LOOKUP_DECIMAL(adc, v,  c)
+#	define SBC_DECIMAL(v, c, t) LOOKUP_DECIMAL(sbc, v, !c)
+
+#else
+#	define ADC_DECIMAL COMPUTE_ADC_DECIMAL
+#	define SBC_DECIMAL COMPUTE_SBC_DECIMAL
+#endif
+
+
+#define ADC(read)							\
+	{								\
+	zuint8 v = read, c = P & CP;					\
+									\
+	if (DECIMAL_MODE)						\
+		{							\
+		ADC_DECIMAL(v, c)					\
+		DECIMAL_CYCLE						\
+		}							\
+									\
+	else	{							\
+		zuint t = (zuint)A + v + c;				\
+									\
+		P &= ~(VP | CP);					\
+									\
+		if (~(A ^ v) & (A ^ t) & 0x80) P |= VP;			\
+		if (t >> 8)		       P |= CP;			\
+									\
+		A = (zuint8)t;						\
+		SET_P_NZ(A);						\
+		}							\
+	}
+
+
+#define SBC(read)						\
+	{							\
+	zuint8 v = read, c = !(P & CP);				\
+	zuint  t = A - v - c;					\
+								\
+	if (DECIMAL_MODE)					\
+		{						\
+		SBC_DECIMAL(v, c, t)				\
+		DECIMAL_CYCLE					\
+		}						\
+								\
+	else	{						\
+		P &= ~(VP | CP);				\
+								\
+		if ((A ^ v) & (A ^ t) & 0x80) P |= VP;		\
+		if (!(t >> 8))		      P |= CP;		\
+								\
+		A = (zuint8)t;					\
+		SET_P_NZ(A);					\
+		}						\
+	}
+
+
+#define INC_DEC(operation, read, WRITE) \
+	{				\
+	zuint8 t = read operation 1;	\
+					\
+	WRITE(t);			\
+	SET_P_NZ(t);			\
+	}
+
+
+#define ASL(read, WRITE)						\
+	{								\
+	zuint8 v = read, t = (zuint8)(v << 1);				\
+									\
+	WRITE(t);							\
+	SET_P_NZC(t, v >> 7);						\
+	}
+
+
+#define LSR(read, WRITE)					\
+	{							\
+	zuint8 v = read, t = v >> 1;				\
+								\
+	WRITE(t);						\
+	SET_P_NZC(t, v & CP);					\
+	}
+
+
+#define ROL(read, WRITE)						\
+	{								\
+	zuint8 v = read, t = (zuint8)((v << 1) | (P & CP));		\
+									\
+	WRITE(t);							\
+	SET_P_NZC(t, v >> 7);						\
+	}
+
+
+#define ROR(read, WRITE)						\
+	{								\
+	zuint8 v = read, t = (zuint8)((v >> 1) | ((P & CP) << 7));	\
+									\
+	WRITE(t);							\
+	SET_P_NZC(t, v & CP);						\
+	}
+
+
+#define BRK										\
+	BYTE_OPERAND; /* BRK padding byte, ignored but the access is emulated */	\
+	PUSH_16(PC + 2);								\
+	PUSH_8(MATERIALIZED_P | BP);							\
+	P |=  BP | IP;									\
+	CLEAR_DECIMAL_ON_INTERRUPT							\
+	PC = READ_POINTER(BRK);
+
+
+#define WRITE_ACCUMULATOR(value) A = value
+
+#define LDA(read) A  = read; SET_P_NZ(A);
+#define LDX(read) X  = read; SET_P_NZ(X);
+#define LDY(read) Y  = read; SET_P_NZ(Y);
+#define AND(read) A &= read; SET_P_NZ(A);
+#define EOR(read) A ^= read; SET_P_NZ(A);
+#define ORA(read) A |= read; SET_P_NZ(A);
+#define CMP(read) COMPARE(A, read)
+#define CPX(read) COMPARE(X, read)
+#define CPY(read) COMPARE(Y, read)
+#define INC(read, WRITE) INC_DEC(+, read, WRITE)
+#define DEC(read, WRITE) INC_DEC(-, read, WRITE)
+
+
+#ifdef CPU_6502_VARIANT_65C02
+#	define TSB(read, WRITE) {zuint8 v = read; SET_P_Z(v & A); WRITE(v |  A);}
+#	define TRB(read, WRITE) {zuint8 v = read; SET_P_Z(v & A); WRITE(v & ~A);}
+#	define BIT_IMMEDIATE(read) SET_P_Z(A & read);
+#endif
+
+
+#ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+
+	/*----------------------------------------------------------------.
+	| Undocumented NMOS opcodes. Most of them combine a read-modify-  |
+	| write operation with an ALU operation on the modified value.	  |
+	| ane and lxa depend on analog effects of the real chip; they use |
+	| the "magic" constant EEh, which matches most NMOS parts.	  |
+	'----------------------------------------------------------------*/
+
+#	define SLO(read, WRITE)						\
+	{								\
+	zuint8 v = read, m = (zuint8)(v << 1);				\
+									\
+	WRITE(m);							\
+	A |= m;								\
+	SET_P_NZC(A, v >> 7);						\
+	}
+
+
+#	define RLA(read, WRITE)						\
+	{								\
+	zuint8 v = read, m = (zuint8)((v << 1) | (P & CP));		\
+									\
+	WRITE(m);							\
+	A &= m;								\
+	SET_P_NZC(A, v >> 7);						\
+	}
+
+
+#	define SRE(read, WRITE)						\
+	{								\
+	zuint8 v = read, m = v >> 1;					\
+									\
+	WRITE(m);							\
+	A ^= m;								\
+	SET_P_NZC(A, v & CP);						\
+	}
+
+
+#	define RRA(read, WRITE)						\
+	{								\
+	zuint8 v = read, m = (zuint8)((v >> 1) | ((P & CP) << 7));	\
+									\
+	WRITE(m);							\
+	P = (zuint8)((P & ~CP) | (v & CP));				\
+	ADC(m)								\
+	}
+
+
+#	define DCP(read, WRITE) \
+	{			\
+	zuint8 m = read - 1;	\
+				\
+	WRITE(m);		\
+	COMPARE(A, m)		\
+	}
+
+
+#	define ISC(read, WRITE) \
+	{			\
+	zuint8 m = read + 1;	\
+				\
+	WRITE(m);		\
+	SBC(m)			\
+	}
+
+
+#	define ARR(read)						\
+	{								\
+	zuint8 m = A & read;						\
+									\
+	A = (zuint8)((m >> 1) | ((P & CP) << 7));			\
+	P &= ~(CP | VP);						\
+	SET_P_NZ(A);							\
+									\
+	if (DECIMAL_MODE)						\
+		{							\
+		P |= (m ^ A) & VP;					\
+									\
+		if ((m & 0x0F) + (m & 0x01) > 0x05)			\
+			A = (zuint8)((A & 0xF0) | ((A + 0x06) & 0x0F)); \
+									\
+		if ((m & 0xF0) + (m & 0x10) > 0x50)			\
+			{						\
+			A += 0x60;					\
+			P |= CP;					\
+			}						\
+		}							\
+									\
+	else P |= ((A >> 6) & CP) | ((A ^ (A << 1)) & VP);		\
+	}
+
+
+#	define SBX(read)						\
+	{								\
+	zuint8 v = read, m = A & X;					\
+									\
+	X = (zuint8)(m - v);						\
+	SET_P_NZC(X, !!(m >= v));					\
+	}
+
+
+	/*-----------------------------------------------------------------.
+	| sha, shx, shy and tas store the register ANDed with the high	   |
+	| byte of the base address plus one. If the indexing crosses a	   |
+	| page boundary, the stored value also replaces the high byte of   |
+	| the effective address.					   |
+	'-----------------------------------------------------------------*/
+
+#	define UNSTABLE_STORE(base, index, value, WRITE)		\
+	{								\
+	zuint16 b = (zuint16)(base), t = (zuint16)(b + index);		\
+	zuint8	v = (zuint8)((value) & ((b >> 8) + 1));			\
+									\
+	if ((b ^ t) & 0xFF00) t = (zuint16)((t & 0xFF) | v << 8);	\
+	WRITE(t, v);							\
+	}
+
+
+#	define LAX(read) A = X = read;		     SET_P_NZ(A);
+#	define LAS(read) A = X = S = read & S;	     SET_P_NZ(A);
+#	define LXA(read) A = X = (A | 0xEE) & read;  SET_P_NZ(A);
+#	define ANE(read) A = (A | 0xEE) & X & read;  SET_P_NZ(A);
+#	define ANC(read) A &= read; SET_P_NZ(A);     P = (zuint8)((P & ~CP) | (A >> 7));
+#	define ALR(read) A &= read; P = (zuint8)((P & ~CP) | (A & CP)); A >>= 1; SET_P_NZ(A);
+
+#endif
+
+
+/* MARK: - Macros: Interrupts */
+
+#define ACCEPT_INTERRUPT(read_vector)						\
+	P &= ~BP;								\
+	PUSH_16(PC);		/* Save return address in the stack.  */	\
+	PUSH_8(MATERIALIZED_P)	/* Save current status in the stack.  */	\
+	PC = read_vector;	/* Make PC point to the routine.      */	\
+	P |= IP;		/* Disable interrupts.		      */	\
+	CLEAR_DECIMAL_ON_INTERRUPT						\
+	CYCLES += 7;		/* Accepting it consumes 7 ticks.     */
+
+
+/* MARK: - Macros: Switch Dispatch */
+
+#define FETCH_OPCODE READ_8(PC)
+
+#define PENALIZED(address_expression, index)		\
+	(address = (zuint16)(address_expression),	\
+	 penalty = (address & 0xFF) + index > 255,	\
+	 READ_8(address + index))
+
+#define ACCUMULATOR		(PC++, A)
+#define WRITE_ADDRESS(value)	 WRITE_8(address, value)
+
+
+#define CASES_J(opcode, OPERATION)									\
+	case opcode | 0x01: OPERATION(READ_8(INDIRECT_X_ADDRESS))		DONE(6);		\
+	case opcode | 0x05: OPERATION(READ_8(ZERO_PAGE_ADDRESS))		DONE(3);		\
+	case opcode | 0x09: OPERATION(READ_BYTE_OPERAND)			DONE(2);		\
+	case opcode | 0x0D: OPERATION(READ_8(ABSOLUTE_ADDRESS))			DONE(4);		\
+	case opcode | 0x11: OPERATION(PENALIZED(READ_16(READ_BYTE_OPERAND), Y))	DONE(5 + penalty);	\
+	case opcode | 0x15: OPERATION(READ_8(ZERO_PAGE_X_ADDRESS))		DONE(4);		\
+	case opcode | 0x19: OPERATION(PENALIZED(READ_WORD_OPERAND, Y))		DONE(4 + penalty);	\
+	case opcode | 0x1D: OPERATION(PENALIZED(READ_WORD_OPERAND, X))		DONE(4 + penalty);
+
+
+#define CASES_G_MEMORY(opcode, OPERATION, absolute_x_cycles)							\
+	case opcode | 0x06: OPERATION(READ_8(address = ZERO_PAGE_ADDRESS),   WRITE_ADDRESS) DONE(5);		\
+	case opcode | 0x0E: OPERATION(READ_8(address = ABSOLUTE_ADDRESS),    WRITE_ADDRESS) DONE(6);		\
+	case opcode | 0x16: OPERATION(READ_8(address = ZERO_PAGE_X_ADDRESS), WRITE_ADDRESS) DONE(6);		\
+	case opcode | 0x1E: OPERATION(READ_8(address = ABSOLUTE_X_ADDRESS),  WRITE_ADDRESS) DONE(absolute_x_cycles);
+
+
+/*-----------------------------------------------------------------.
+| On the 65C02, the shifts with absolute,X addressing save a cycle |
+| if the indexing does not cross a page boundary.		   |
+'-----------------------------------------------------------------*/
+
+#ifdef CPU_6502_VARIANT_65C02
+#	define SHIFT_ABSOLUTE_X_CYCLES (6 + ((address & 0xFF) < X))
+#else
+#	define SHIFT_ABSOLUTE_X_CYCLES 7
+#endif
+
+
+#define CASES_G(opcode, OPERATION)							\
+	case opcode | 0x0A: OPERATION(ACCUMULATOR, WRITE_ACCUMULATOR) DONE(2);		\
+	CASES_G_MEMORY(opcode, OPERATION, SHIFT_ABSOLUTE_X_CYCLES)
+
+
+#ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+
+#	define CASES_L(opcode, OPERATION)									\
+		case opcode | 0x03: OPERATION(READ_8(address = INDIRECT_X_ADDRESS),  WRITE_ADDRESS) DONE(8);	\
+		case opcode | 0x07: OPERATION(READ_8(address = ZERO_PAGE_ADDRESS),   WRITE_ADDRESS) DONE(5);	\
+		case opcode | 0x0F: OPERATION(READ_8(address = ABSOLUTE_ADDRESS),    WRITE_ADDRESS) DONE(6);	\
+		case opcode | 0x13: OPERATION(READ_8(address = INDIRECT_Y_ADDRESS),  WRITE_ADDRESS) DONE(8);	\
+		case opcode | 0x17: OPERATION(READ_8(address = ZERO_PAGE_X_ADDRESS), WRITE_ADDRESS) DONE(6);	\
+		case opcode | 0x1B: OPERATION(READ_8(address = ABSOLUTE_Y_ADDRESS),  WRITE_ADDRESS) DONE(7);	\
+		case opcode | 0x1F: OPERATION(READ_8(address = ABSOLUTE_X_ADDRESS),  WRITE_ADDRESS) DONE(7);
+
+
+#	define UNDOCUMENTED_CASES										\
+		CASES_L(0x00, SLO) CASES_L(0x20, RLA) CASES_L(0x40, SRE) CASES_L(0x60, RRA)			\
+		CASES_L(0xC0, DCP) CASES_L(0xE0, ISC)								\
+														\
+		/* sax M, lax M, lxa, las */									\
+		case 0x83: WRITE_8(INDIRECT_X_ADDRESS,	A & X);				DONE(6);		\
+		case 0x87: WRITE_8(ZERO_PAGE_ADDRESS,	A & X);				DONE(3);		\
+		case 0x8F: WRITE_8(ABSOLUTE_ADDRESS,	A & X);				DONE(4);		\
+		case 0x97: WRITE_8(ZERO_PAGE_Y_ADDRESS, A & X);				DONE(4);		\
+		case 0xA3: LAX(READ_8(INDIRECT_X_ADDRESS))				DONE(6);		\
+		case 0xA7: LAX(READ_8(ZERO_PAGE_ADDRESS))				DONE(3);		\
+		case 0xAF: LAX(READ_8(ABSOLUTE_ADDRESS))				DONE(4);		\
+		case 0xB3: LAX(PENALIZED(READ_16(READ_BYTE_OPERAND), Y))		DONE(5 + penalty);	\
+		case 0xB7: LAX(READ_8(ZERO_PAGE_Y_ADDRESS))				DONE(4);		\
+		case 0xBF: LAX(PENALIZED(READ_WORD_OPERAND, Y))				DONE(4 + penalty);	\
+		case 0xAB: LXA(READ_BYTE_OPERAND)					DONE(2);		\
+		case 0xBB: LAS(PENALIZED(READ_WORD_OPERAND, Y))				DONE(4 + penalty);	\
+														\
+		/* anc, alr, arr, ane, sbx, sbc (immediate) */							\
+		case 0x0B:											\
+		case 0x2B: ANC(READ_BYTE_OPERAND)					DONE(2);		\
+		case 0x4B: ALR(READ_BYTE_OPERAND)					DONE(2);		\
+		case 0x6B: ARR(READ_BYTE_OPERAND)					DONE(2);		\
+		case 0x8B: ANE(READ_BYTE_OPERAND)					DONE(2);		\
+		case 0xCB: SBX(READ_BYTE_OPERAND)					DONE(2);		\
+		case 0xEB: SBC(READ_BYTE_OPERAND)					DONE(2);		\
+														\
+		/* sha, shx, shy, tas */									\
+		case 0x93: UNSTABLE_STORE(READ_16(READ_BYTE_OPERAND), Y, A & X, WRITE_8) DONE(6);		\
+		case 0x9F: UNSTABLE_STORE(READ_WORD_OPERAND, Y, A & X, WRITE_8)		DONE(5);		\
+		case 0x9E: UNSTABLE_STORE(READ_WORD_OPERAND, Y, X, WRITE_8)		DONE(5);		\
+		case 0x9C: UNSTABLE_STORE(READ_WORD_OPERAND, X, Y, WRITE_8)		DONE(5);		\
+		case 0x9B: S = A & X; UNSTABLE_STORE(READ_WORD_OPERAND, Y, S, WRITE_8)	DONE(5);		\
+														\
+		/* nop with operand */										\
+		case 0x80: case 0x82: case 0x89: case 0xC2: case 0xE2:						\
+		READ_BYTE_OPERAND;							DONE(2);		\
+														\
+		case 0x04: case 0x44: case 0x64:								\
+		READ_8(ZERO_PAGE_ADDRESS);						DONE(3);		\
+														\
+		case 0x14: case 0x34: case 0x54: case 0x74: case 0xD4: case 0xF4:				\
+		READ_8(ZERO_PAGE_X_ADDRESS);						DONE(4);		\
+														\
+		case 0x0C: READ_8(ABSOLUTE_ADDRESS);					DONE(4);		\
+														\
+		case 0x1C: case 0x3C: case 0x5C: case 0x7C: case 0xDC: case 0xFC:				\
+		PENALIZED(READ_WORD_OPERAND, X);					DONE(4 + penalty);	\
+														\
+		/* jam */											\
+		case 0x02: case 0x12: case 0x22: case 0x32: case 0x42: case 0x52:				\
+		case 0x62: case 0x72: case 0x92: case 0xB2: case 0xD2: case 0xF2:				\
+		JAMMED = TRUE;								DONE(2);
+
+#else
+#	define UNDOCUMENTED_CASES
+#endif
+
+
+#ifdef CPU_6502_VARIANT_65C02
+
+#	define CASES_NOP_1(row) \
+		case row | 0x03: case row | 0x07: case row | 0x0B: case row | 0x0F:
+
+
+#	define CMOS_CASES											\
+		/* J (BYTE) */											\
+		case 0x12: ORA(READ_8(INDIRECT_ZP_ADDRESS))				DONE(5);		\
+		case 0x32: AND(READ_8(INDIRECT_ZP_ADDRESS))				DONE(5);		\
+		case 0x52: EOR(READ_8(INDIRECT_ZP_ADDRESS))				DONE(5);		\
+		case 0x72: ADC(READ_8(INDIRECT_ZP_ADDRESS))				DONE(5);		\
+		case 0x92: WRITE_8(INDIRECT_ZP_ADDRESS, A);				DONE(5);		\
+		case 0xB2: LDA(READ_8(INDIRECT_ZP_ADDRESS))				DONE(5);		\
+		case 0xD2: CMP(READ_8(INDIRECT_ZP_ADDRESS))				DONE(5);		\
+		case 0xF2: SBC(READ_8(INDIRECT_ZP_ADDRESS))				DONE(5);		\
+														\
+		/* bit, stz, tsb, trb */									\
+		case 0x89: BIT_IMMEDIATE(READ_BYTE_OPERAND)				DONE(2);		\
+		case 0x34: BIT(READ_8(ZERO_PAGE_X_ADDRESS))				DONE(4);		\
+		case 0x3C: BIT(PENALIZED(READ_WORD_OPERAND, X))				DONE(4 + penalty);	\
+		case 0x64: WRITE_8(ZERO_PAGE_ADDRESS,	0);				DONE(3);		\
+		case 0x74: WRITE_8(ZERO_PAGE_X_ADDRESS, 0);				DONE(4);		\
+		case 0x9C: WRITE_8(ABSOLUTE_ADDRESS,	0);				DONE(4);		\
+		case 0x9E: WRITE_8(ABSOLUTE_X_ADDRESS,	0);				DONE(5);		\
+		case 0x04: TSB(READ_8(address = ZERO_PAGE_ADDRESS), WRITE_ADDRESS)	DONE(5);		\
+		case 0x0C: TSB(READ_8(address = ABSOLUTE_ADDRESS),  WRITE_ADDRESS)	DONE(6);		\
+		case 0x14: TRB(READ_8(address = ZERO_PAGE_ADDRESS), WRITE_ADDRESS)	DONE(5);		\
+		case 0x1C: TRB(READ_8(address = ABSOLUTE_ADDRESS),  WRITE_ADDRESS)	DONE(6);		\
+														\
+		/* inc A, dec A, phx, phy, plx, ply, bra, jmp (WORD,X) */					\
+		case 0x1A: PC++; A++; SET_P_NZ(A);					DONE(2);		\
+		case 0x3A: PC++; A--; SET_P_NZ(A);					DONE(2);		\
+		case 0xDA: PC++; PUSH_8(X)						DONE(3);		\
+		case 0x5A: PC++; PUSH_8(Y)						DONE(3);		\
+		case 0xFA: PC++; X = POP_8; SET_P_NZ(X);				DONE(4);		\
+		case 0x7A: PC++; Y = POP_8; SET_P_NZ(Y);				DONE(4);		\
+		case 0x80: BRANCH(TRUE, instruction_cycles)				break;			\
+		case 0x7C: PC = READ_16(WORD_OPERAND + X);				DONE(6);		\
+														\
+		/* nop with operand */										\
+		case 0x02: case 0x22: case 0x42: case 0x62: case 0x82: case 0xC2: case 0xE2:			\
+		READ_BYTE_OPERAND;							DONE(2);		\
+														\
+		case 0x44: READ_8(ZERO_PAGE_ADDRESS);					DONE(3);		\
+														\
+		case 0x54: case 0xD4: case 0xF4:								\
+		READ_8(ZERO_PAGE_X_ADDRESS);						DONE(4);		\
+														\
+		case 0xDC: case 0xFC: READ_8(ABSOLUTE_ADDRESS);				DONE(4);		\
+		case 0x5C: PC += 3;							DONE(8);		\
+														\
+		/* One-byte, one-cycle nops */									\
+		CASES_NOP_1(0x00) CASES_NOP_1(0x10) CASES_NOP_1(0x20) CASES_NOP_1(0x30)				\
+		CASES_NOP_1(0x40) CASES_NOP_1(0x50) CASES_NOP_1(0x60) CASES_NOP_1(0x70)				\
+		CASES_NOP_1(0x80) CASES_NOP_1(0x90) CASES_NOP_1(0xA0) CASES_NOP_1(0xB0)				\
+		CASES_NOP_1(0xC0) CASES_NOP_1(0xD0) CASES_NOP_1(0xE0) CASES_NOP_1(0xF0)				\
+		PC++;									DONE(1);
+
+#else
+#	define CMOS_CASES
+#endif
+
+
+#define SWITCH_DISPATCH										\
+	switch (FETCH_OPCODE)									\
+		{										\
+		CASES_J(0x00, ORA) CASES_J(0x20, AND) CASES_J(0x40, EOR) CASES_J(0x60, ADC)	\
+		CASES_J(0xA0, LDA) CASES_J(0xC0, CMP) CASES_J(0xE0, SBC)			\
+												\
+		CASES_G(0x00, ASL) CASES_G(0x20, ROL) CASES_G(0x40, LSR) CASES_G(0x60, ROR)	\
+		CASES_G_MEMORY(0xC0, DEC, 7) CASES_G_MEMORY(0xE0, INC, 7)			\
+												\
+		/* sta K */									\
+		case 0x81: WRITE_8(INDIRECT_X_ADDRESS,	A);		  DONE(6);		\
+		case 0x85: WRITE_8(ZERO_PAGE_ADDRESS,	A);		  DONE(3);		\
+		case 0x8D: WRITE_8(ABSOLUTE_ADDRESS,	A);		  DONE(4);		\
+		case 0x91: WRITE_8(INDIRECT_Y_ADDRESS,	A);		  DONE(6);		\
+		case 0x95: WRITE_8(ZERO_PAGE_X_ADDRESS, A);		  DONE(4);		\
+		case 0x99: WRITE_8(ABSOLUTE_Y_ADDRESS,	A);		  DONE(5);		\
+		case 0x9D: WRITE_8(ABSOLUTE_X_ADDRESS,	A);		  DONE(5);		\
+												\
+		/* ldx H, stx H */								\
+		case 0xA2: LDX(READ_BYTE_OPERAND)			  DONE(2);		\
+		case 0xA6: LDX(READ_8(ZERO_PAGE_ADDRESS))		  DONE(3);		\
+		case 0xAE: LDX(READ_8(ABSOLUTE_ADDRESS))		  DONE(4);		\
+		case 0xB6: LDX(READ_8(ZERO_PAGE_Y_ADDRESS))		  DONE(4);		\
+		case 0xBE: LDX(PENALIZED(READ_WORD_OPERAND, Y))		  DONE(4 + penalty);	\
+		case 0x86: WRITE_8(ZERO_PAGE_ADDRESS,	X);		  DONE(3);		\
+		case 0x8E: WRITE_8(ABSOLUTE_ADDRESS,	X);		  DONE(4);		\
+		case 0x96: WRITE_8(ZERO_PAGE_Y_ADDRESS, X);		  DONE(4);		\
+												\
+		/* ldy Q, sty Q, bit Q, cpy Q, cpx Q */						\
+		case 0xA0: LDY(READ_BYTE_OPERAND)			  DONE(2);		\
+		case 0xA4: LDY(READ_8(ZERO_PAGE_ADDRESS))		  DONE(3);		\
+		case 0xAC: LDY(READ_8(ABSOLUTE_ADDRESS))		  DONE(4);		\
+		case 0xB4: LDY(READ_8(ZERO_PAGE_X_ADDRESS))		  DONE(4);		\
+		case 0xBC: LDY(PENALIZED(READ_WORD_OPERAND, X))		  DONE(4 + penalty);	\
+		case 0x84: WRITE_8(ZERO_PAGE_ADDRESS,	Y);		  DONE(3);		\
+		case 0x8C: WRITE_8(ABSOLUTE_ADDRESS,	Y);		  DONE(4);		\
+		case 0x94: WRITE_8(ZERO_PAGE_X_ADDRESS, Y);		  DONE(4);		\
+		case 0x24: BIT(READ_8(ZERO_PAGE_ADDRESS))		  DONE(3);		\
+		case 0x2C: BIT(READ_8(ABSOLUTE_ADDRESS))		  DONE(4);		\
+		case 0xC0: CPY(READ_BYTE_OPERAND)			  DONE(2);		\
+		case 0xC4: CPY(READ_8(ZERO_PAGE_ADDRESS))		  DONE(3);		\
+		case 0xCC: CPY(READ_8(ABSOLUTE_ADDRESS))		  DONE(4);		\
+		case 0xE0: CPX(READ_BYTE_OPERAND)			  DONE(2);		\
+		case 0xE4: CPX(READ_8(ZERO_PAGE_ADDRESS))		  DONE(3);		\
+		case 0xEC: CPX(READ_8(ABSOLUTE_ADDRESS))		  DONE(4);		\
+												\
+		/* Register transfers, stack operations, increments & decrements */		\
+		case 0xAA: PC++; X = A; SET_P_NZ(X);			  DONE(2);		\
+		case 0xA8: PC++; Y = A; SET_P_NZ(Y);			  DONE(2);		\
+		case 0x8A: PC++; A = X; SET_P_NZ(A);			  DONE(2);		\
+		case 0x98: PC++; A = Y; SET_P_NZ(A);			  DONE(2);		\
+		case 0xBA: PC++; X = S; SET_P_NZ(X);			  DONE(2);		\
+		case 0x9A: PC++; S = X;					  DONE(2);		\
+		case 0x48: PC++; PUSH_8(A)				  DONE(3);		\
+		case 0x08: PC++; PUSH_8(MATERIALIZED_P)			  DONE(3);		\
+		case 0x68: PC++; A = POP_8; SET_P_NZ(A);		  DONE(4);		\
+		case 0x28: PC++; P = POP_8; NZ_FROM_P PENDING = TRUE;	  DONE(4);		\
+		case 0xE8: PC++; X++; SET_P_NZ(X);			  DONE(2);		\
+		case 0xC8: PC++; Y++; SET_P_NZ(Y);			  DONE(2);		\
+		case 0xCA: PC++; X--; SET_P_NZ(X);			  DONE(2);		\
+		case 0x88: PC++; Y--; SET_P_NZ(Y);			  DONE(2);		\
+												\
+		/* Jumps, calls & branches */							\
+		case 0x4C: PC = WORD_OPERAND;				  DONE(3);		\
+		case 0x6C: PC = READ_16(WORD_OPERAND);			  DONE(JMP_IND_CYCLES); \
+		case 0x20: PUSH_16(PC + 2); PC = WORD_OPERAND;		  DONE(6);		\
+		case 0x60: PC = POP_16 + 1;				  DONE(6);		\
+		case 0x90: BRANCH_IF_CLEAR(CP, instruction_cycles)	  break;		\
+		case 0xB0: BRANCH_IF_SET  (CP, instruction_cycles)	  break;		\
+		case 0xF0: BRANCH_IF_SET  (ZP, instruction_cycles)	  break;		\
+		case 0x30: BRANCH_IF_SET  (NP, instruction_cycles)	  break;		\
+		case 0xD0: BRANCH_IF_CLEAR(ZP, instruction_cycles)	  break;		\
+		case 0x10: BRANCH_IF_CLEAR(NP, instruction_cycles)	  break;		\
+		case 0x50: BRANCH_IF_CLEAR(VP, instruction_cycles)	  break;		\
+		case 0x70: BRANCH_IF_SET  (VP, instruction_cycles)	  break;		\
+												\
+		/* Status flag changes & system functions */					\
+		case 0x18: PC++; P &= ~CP;				  DONE(2);		\
+		case 0xD8: PC++; P &= ~DP;				  DONE(2);		\
+		case 0x58: PC++; P &= ~IP; PENDING = TRUE;		  DONE(2);		\
+		case 0xB8: PC++; P &= ~VP;				  DONE(2);		\
+		case 0x38: PC++; P |=  CP;				  DONE(2);		\
+		case 0xF8: PC++; P |=  DP;				  DONE(2);		\
+		case 0x78: PC++; P |=  IP;				  DONE(2);		\
+		case 0x40: P = POP_8; NZ_FROM_P PC = POP_16; PENDING = TRUE; DONE(6);		\
+		case 0x00: BRK						  DONE(7);		\
+												\
+		UNDOCUMENTED_CASES								\
+		CMOS_CASES									\
+												\
+		/* nop and illegal opcodes */							\
+		default: PC++;						  DONE(2);		\
+		}
+
+#else
+#	undef A
+#	undef ABSOLUTE_ADDRESS
+#	undef ABSOLUTE_X_ADDRESS
+#	undef ABSOLUTE_Y_ADDRESS
+#	undef ACCEPT_INTERRUPT
+#	undef ACCUMULATOR
+#	undef ADC
+#	undef ADC_DECIMAL
+#	undef ALR
+#	undef ANC
+#	undef AND
+#	undef ANE
+#	undef ARR
+#	undef ASL
+#	undef BIT
+#	undef BIT_IMMEDIATE
+#	undef BP
+#	undef BRANCH
+#	undef BRANCH_IF_CLEAR
+#	undef BRANCH_IF_SET
+#	undef BRK
+#	undef BYTE_OPERAND
+#	undef CASES_G
+#	undef CASES_G_MEMORY
+#	undef CASES_J
+#	undef CASES_L
+#	undef CASES_NOP_1
+#	undef CLEAR_DECIMAL_ON_INTERRUPT
+#	undef CMOS_CASES
+#	undef CMP
+#	undef COMPARE
+#	undef COMPUTE_ADC_DECIMAL
+#	undef COMPUTE_SBC_DECIMAL
+#	undef CP
+#	undef CPX
+#	undef CPY
+#	undef CYCLES
+#	undef DCP
+#	undef DEC
+#	undef DECIMAL_CYCLE
+#	undef DECIMAL_MODE
+#	undef DECIMAL_NZ
+#	undef DP
+#	undef EA
+#	undef EA_CYCLES
+#	undef EOR
+#	undef FETCH_OPCODE
+#	undef FLAG
+#	undef INC
+#	undef INC_DEC
+#	undef INDIRECT_X_ADDRESS
+#	undef INDIRECT_Y_ADDRESS
+#	undef INDIRECT_ZP_ADDRESS
+#	undef IP
+#	undef IRQ
+#	undef ISC
+#	undef JAMMED
+#	undef JMP_IND_CYCLES
+#	undef LAS
+#	undef LAX
+#	undef LDA
+#	undef LDX
+#	undef LDY
+#	undef LOOKUP_DECIMAL
+#	undef LSR
+#	undef LXA
+#	undef MATERIALIZED_P
+#	undef NMI
+#	undef NP
+#	undef NZ
+#	undef NZCP
+#	undef NZP
+#	undef NZ_FROM_P
+#	undef N_FLAG
+#	undef OPCODE
+#	undef ORA
+#	undef P
+#	undef PC
+#	undef PENALIZED
+#	undef PENDING
+#	undef POP_8
+#	undef PUSH_8
+#	undef P_FROM_NZ
+#	undef READ_BYTE_OPERAND
+#	undef READ_POINTER
+#	undef READ_WORD_OPERAND
+#	undef REGISTERS
+#	undef RLA
+#	undef ROL
+#	undef ROR
+#	undef RRA
+#	undef S
+#	undef SBC
+#	undef SBC_DECIMAL
+#	undef SBX
+#	undef SET_P_NZ
+#	undef SET_P_NZC
+#	undef SET_P_N_Z
+#	undef SET_P_Z
+#	undef SHIFT_ABSOLUTE_X_CYCLES
+#	undef SLO
+#	undef SRE
+#	undef SWITCH_DISPATCH
+#	undef TRB
+#	undef TSB
+#	undef UNDOCUMENTED_CASES
+#	undef UNSTABLE_STORE
+#	undef VP
+#	undef WORD_OPERAND
+#	undef WRITE_ACCUMULATOR
+#	undef WRITE_ADDRESS
+#	undef X
+#	undef Y
+#	undef ZERO_PAGE_ADDRESS
+#	undef ZERO_PAGE_X_ADDRESS
+#	undef ZERO_PAGE_Y_ADDRESS
+#	undef ZP
+#	undef ZP_ZERO
+#	undef Z_FLAG
+#endif
+
+/* 6502-semantics.h EOF */
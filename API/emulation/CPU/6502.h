@@ -29,12 +29,337 @@
 #	include <Z/hardware/CPU/architecture/6502.h>
 #endif
 
+#if (	defined(CPU_6502_WITH_DECODE_CACHE)  || defined(CPU_6502_WITH_COPY_ON_WRITE) || \
+	defined(CPU_6502_WITH_FAST_FORWARD)) && !defined(CPU_6502_WITH_PAGE_TABLE)
+#	define CPU_6502_WITH_PAGE_TABLE
+#endif
+
+#if (	defined(CPU_6502_WITH_TRACE)	 || defined(CPU_6502_WITH_BREAKPOINTS) || \
+	defined(CPU_6502_WITH_RUN_UNTIL) || defined(CPU_6502_WITH_PROFILER))   && \
+	!defined(CPU_6502_WITH_HOOKS)
+#	define CPU_6502_WITH_HOOKS
+#endif
+
+#if defined(CPU_6502_WITH_DECODE_CACHE) || defined(CPU_6502_WITH_FETCH)
+
+	/** Pre-decoded 6502 instruction.
+	  * @details This is an internal private type used by the decode cache
+	  * and the fetch callback. */
+
+	typedef struct {
+		zuint16 operand;
+		zuint8	opcode;
+		zuint8	valid;
+	} M6502DecodedInstruction;
+
+#endif
+
+#ifdef CPU_6502_WITH_DECODE_CACHE
+
+	/** Decode cache.
+	  * @details It holds one pre-decoded instruction per address, plus one
+	  * flag per 256-byte page indicating whether the page contains bytes of
+	  * cached instructions. It must be allocated by the host and cleared to
+	  * zero before it is assigned to an emulator instance. */
+
+	typedef struct {
+		zuint8			code_pages[256];
+		M6502DecodedInstruction instructions[65536];
+	} M6502DecodeCache;
+
+#endif
+
+#ifdef CPU_6502_WITH_DECIMAL_TABLES
+
+	/** Decimal mode lookup tables.
+	  * @details They hold the results of @c adc and @c sbc in decimal mode,
+	  * indexed by the C flag, the accumulator and the operand. Each element
+	  * contains the resulting accumulator in its low byte and the resulting
+	  * N, V, Z and C flags in its high byte. They must be allocated by the
+	  * host and filled with @c m6502_build_decimal_tables, and can be shared
+	  * by any number of emulator instances. */
+
+	typedef struct {
+		zuint16 adc[2][256][256];
+		zuint16 sbc[2][256][256];
+	} M6502DecimalTables;
+
+#endif
+
+#ifdef CPU_6502_WITH_RECORD_REPLAY
+#	define M6502_LOG_MODE_OFF    0
+#	define M6502_LOG_MODE_RECORD 1
+#	define M6502_LOG_MODE_REPLAY 2
+#endif
+
+#ifdef CPU_6502_WITH_HOOKS
+#	define M6502_ACCESS_OPCODE  0
+#	define M6502_ACCESS_OPERAND 1
+#	define M6502_ACCESS_DATA    2
+#	define M6502_ACCESS_STACK   3
+#	define M6502_ACCESS_VECTOR  4
+
+	/** Hooks called by @c m6502_run to report the execution.
+	  * @details Any of them can be @c NULL. @c on_instruction is called
+	  * before executing each instruction, with the address and the value
+	  * of its opcode. @c on_fetch is called after reading the opcode or an
+	  * operand of an instruction (@c M6502_ACCESS_OPCODE or
+	  * @c M6502_ACCESS_OPERAND). @c on_data_read and @c on_data_write are
+	  * called after any other memory access, which can be a data access
+	  * (@c M6502_ACCESS_DATA), a stack access (@c M6502_ACCESS_STACK) or
+	  * the read of an interrupt vector (@c M6502_ACCESS_VECTOR). */
+
+	typedef struct {
+		void (* on_instruction)(void *context, zuint16 pc, zuint8 opcode);
+		void (* on_fetch      )(void *context, zuint16 address, zuint8 value, zuint8 kind);
+		void (* on_data_read  )(void *context, zuint16 address, zuint8 value, zuint8 kind);
+		void (* on_data_write )(void *context, zuint16 address, zuint8 value, zuint8 kind);
+	} M6502Hooks;
+
+#endif
+
+#ifdef CPU_6502_WITH_BREAKPOINTS
+#	define M6502_BREAK_NONE	   0
+#	define M6502_BREAK_EXECUTE 1
+#	define M6502_BREAK_READ	   2
+#	define M6502_BREAK_WRITE   3
+
+	/** Breakpoints and watchpoints.
+	  * @details Each bitmap has one bit per address, which is the bit
+	  * <tt>address & 7</tt> of the element <tt>address >> 3</tt>. This
+	  * structure must be allocated by the host, which can set and clear
+	  * the bits at any time except during the execution of
+	  * @c m6502_run. */
+
+	typedef struct {
+
+		/** Addresses of the instructions that stop the execution
+		  * before being executed. */
+
+		zuint8 execute[8192];
+
+		/** Addresses whose reading stops the execution after the
+		  * instruction that reads them. */
+
+		zuint8 read[8192];
+
+		/** Addresses whose writing stops the execution after the
+		  * instruction that writes them. */
+
+		zuint8 write[8192];
+
+		/** Callback: Called when a breakpoint or watchpoint is hit, to
+		  * decide whether the execution must stop.
+		  * @details It can be @c NULL, in which case the execution always
+		  * stops. Write watchpoints are checked after the write, so the
+		  * callback can read the value written from memory.
+		  * @param context The value of the member @c context of the
+		  * emulator instance.
+		  * @param reason @c M6502_BREAK_EXECUTE, @c M6502_BREAK_READ or
+		  * @c M6502_BREAK_WRITE.
+		  * @param address The address of the instruction, or the address
+		  * accessed.
+		  * @return @c TRUE if the execution must stop; @c FALSE
+		  * otherwise. */
+
+		zboolean (* condition)(void *context, zuint8 reason, zuint16 address);
+
+		/** Reason why the last call to @c m6502_run stopped, or
+		  * @c M6502_BREAK_NONE if it executed all the cycles requested.
+		  * @details @c m6502_run returns the number of cycles executed
+		  * until the stop. An execute breakpoint is ignored for the first
+		  * instruction after stopping at it, so that calling @c m6502_run
+		  * again resumes the execution. */
+
+		zuint8 reason;
+
+		/** Address of the breakpoint or watchpoint that stopped the last
+		  * call to @c m6502_run. */
+
+		zuint16 address;
+	} M6502Breakpoints;
+
+#endif
+
+#ifdef CPU_6502_WITH_RUN_UNTIL
+#	define M6502_UNTIL_PC		1
+#	define M6502_UNTIL_RETURN	2
+#	define M6502_UNTIL_INSTRUCTIONS 4
+
+	/** Stop conditions of @c m6502_run_until.
+	  * @details They are checked after each instruction. */
+
+	typedef struct {
+
+		/** Conditions to check: any combination of @c M6502_UNTIL_PC,
+		  * @c M6502_UNTIL_RETURN and @c M6502_UNTIL_INSTRUCTIONS. */
+
+		zuint8 conditions;
+
+		/** Condition that stopped the execution, or @c 0 if it did not
+		  * stop before executing the cycles requested. */
+
+		zuint8 reason;
+
+		/** Address of the next instruction at which to stop
+		  * (@c M6502_UNTIL_PC). */
+
+		zuint16 pc;
+
+		/** Value of S at which to stop after an @c rts or @c rti
+		  * (@c M6502_UNTIL_RETURN).
+		  * @details The execution stops when one of these instructions
+		  * leaves S greater than or equal to this value. To step over a
+		  * @c jsr, set it to the value of S before executing it; to run
+		  * until the current subroutine returns, set it to S + 1. */
+
+		zuint8 frame;
+
+		/** Number of instructions after which to stop
+		  * (@c M6502_UNTIL_INSTRUCTIONS).
+		  * @details It must be greater than @c 0, and it is decremented
+		  * after each instruction. */
+
+		zusize instructions;
+	} M6502Until;
+
+#endif
+
+#ifdef CPU_6502_WITH_TRACE
+
+	/** Instruction of an execution trace.
+	  * @details @c cycle is the number of cycles elapsed since the start of
+	  * the trace at the end of the instruction; @c pc and @c opcode are the
+	  * address and the value of its opcode; @c a, @c x, @c y, @c s and @c p
+	  * are the values of the registers after executing it; and @c ea is the
+	  * address of the last data access performed by the instruction, if
+	  * @c has_ea is @c TRUE. */
+
+	typedef struct {
+		zusize	 cycle;
+		zuint16	 pc;
+		zuint16	 ea;
+		zuint8	 opcode;
+		zuint8	 a, x, y, s, p;
+		zboolean has_ea;
+	} M6502TraceRecord;
+
+	/** Execution trace writer.
+	  * @details The host must clear it to zero and then initialize
+	  * @c buffers, @c buffer_size and @c flush. The records are written to
+	  * one buffer while the other one is being flushed, and each buffer
+	  * can be decoded independently with @c m6502_trace_decode. The rest
+	  * of the members are internal private variables. */
+
+	typedef struct {
+
+		/** Two buffers of @c buffer_size bytes provided by the host. */
+
+		zuint8 *buffers[2];
+
+		/** Size in bytes of each element of @c buffers.
+		  * @details It must be greater than or equal to
+		  * @c M6502_TRACE_MAXIMUM_RECORD_SIZE. */
+
+		zusize buffer_size;
+
+		/** Callback: Called when a buffer is full.
+		  * @details The callback takes ownership of the buffer until the
+		  * next call, so it can hand the buffer to another thread and
+		  * return immediately, but it must not return from the next call
+		  * before the previous buffer has been written out.
+		  * @param context The value of the member @c context of the
+		  * emulator instance.
+		  * @param data The records.
+		  * @param size The size of @c data in bytes. */
+
+		void (* flush)(void *context, zuint8 const *data, zusize size);
+
+		/** Number of cycles executed before the current call to
+		  * @c m6502_run.
+		  * @details @c m6502_run advances it before returning. */
+
+		zusize clock;
+
+		zusize		 index;
+		zuint8		 buffer;
+		M6502TraceRecord last;
+	} M6502Trace;
+
+#	define M6502_TRACE_MAXIMUM_RECORD_SIZE (11 + (sizeof(zusize) * 8 + 6) / 7)
+
+#endif
+
+#ifdef CPU_6502_WITH_PROFILER
+
+	/** Execution profile.
+	  * @details The counters indexed by opcode follow the order of the
+	  * instruction table. The interrupt responses are not counted. */
+
+	typedef struct {
+
+		/** Number of times each opcode has been executed. */
+
+		zusize executions[256];
+
+		/** Number of cycles consumed by each opcode. */
+
+		zusize cycles[256];
+
+		/** Number of times each opcode has taken an extra cycle because
+		  * the indexing of its effective address crossed a page boundary.
+		  * @details Only the instructions that read memory with absolute,X,
+		  * absolute,Y and (indirect),Y addressing are counted here. */
+
+		zusize page_crossings[256];
+
+		/** Number of times each conditional branch has been taken. */
+
+		zusize branches_taken[256];
+
+		/** Number of times each conditional branch has not been taken. */
+
+		zusize branches_not_taken[256];
+
+		/** Number of instructions executed at each address.
+		  * @details The counters wrap around on overflow. */
+
+		zuint32 pc_hits[65536];
+	} M6502Profile;
+
+#endif
+
+#ifdef CPU_6502_WITH_EVENTS
+
+	/** Event scheduled with @c m6502_schedule.
+	  * @details This is an internal private type used by the event queue. */
+
+	typedef struct {
+		zusize cycle;
+		void   (* callback)(void *context, zusize cycle);
+	} M6502Event;
+
+#endif
+
 /** 6502 emulator instance.
   * @details This structure contains the state of the emulated CPU and callback
   * pointers necessary to interconnect the emulator with external logic. There
   * is no constructor function, so, before using an object of this type, some
   * of its members must be initialized, in particular the following:
-  * @c context, @c read and @c write. */
+  * @c context, @c read and @c write (and also @c fetch if the emulator has
+  * been built with @c CPU_6502_WITH_FETCH, @c read_pages and
+  * @c write_pages if the emulator has been built with
+  * @c CPU_6502_WITH_PAGE_TABLE, @c coherent_state if it has been built with
+  * @c CPU_6502_WITH_REGISTER_CACHE, @c decode_cache if it has been built
+  * with @c CPU_6502_WITH_DECODE_CACHE, @c decimal_tables if it has been
+  * built with @c CPU_6502_WITH_DECIMAL_TABLES, @c hooks if it has been built
+  * with @c CPU_6502_WITH_HOOKS, @c trace if it has been built with
+  * @c CPU_6502_WITH_TRACE, @c breakpoints if it has been built with
+  * @c CPU_6502_WITH_BREAKPOINTS, @c profile if it has been built with
+  * @c CPU_6502_WITH_PROFILER, @c copy_page if it has been built with
+  * @c CPU_6502_WITH_COPY_ON_WRITE, @c events, @c event_capacity and
+  * @c event_count if it has been built with @c CPU_6502_WITH_EVENTS, and
+  * @c log_mode if it has been built with @c CPU_6502_WITH_RECORD_REPLAY). */
 
 typedef struct {
 
@@ -67,6 +392,24 @@ typedef struct {
 
 	void (* write)(void *context, zuint16 address, zuint8 value);
 
+#ifdef CPU_6502_WITH_FETCH
+
+	/** Callback: Called when the CPU fetches an instruction, or @c NULL
+	  * to fetch it through @c read.
+	  * @details The operands of the instruction are taken from the value
+	  * returned, so only the data accesses are performed through @c read.
+	  * Since some of the bytes returned may not belong to the instruction,
+	  * this callback must not have side effects.
+	  * @param context The value of the member @c context.
+	  * @param address The memory address of the opcode.
+	  * @return The opcode in bits 0-7, and the bytes located at
+	  * <tt>address + 1</tt> and <tt>address + 2</tt> in bits 8-15 and 16-23,
+	  * respectively. */
+
+	zuint32 (* fetch)(void *context, zuint16 address);
+
+#endif
+
 	/** CPU registers and internal bits.
 	  * @details It contains the state of the registers and the interrupt
 	  * flags. This is what a debugger should use as its data source. */
@@ -88,6 +431,248 @@ typedef struct {
 	  * @details This is an internal private variable. */
 
 	zuint16 ea;
+
+	/** Whether the interrupt lines must be checked before the next
+	  * instruction.
+	  * @details This is an internal private variable. */
+
+	zboolean interrupt_pending;
+
+#ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+
+	/** Whether the CPU has been halted by a jam opcode.
+	  * @details A halted CPU executes the same opcode again and again and
+	  * ignores the interrupts. @c m6502_power and @c m6502_reset clear it. */
+
+	zboolean jammed;
+
+#endif
+
+#ifdef CPU_6502_WITH_PAGE_TABLE
+
+	/** Direct read access to memory, one element per 256-byte page.
+	  * @details Each element points to the 256 bytes of host memory that
+	  * back the corresponding page of the address space. Reads from pages
+	  * whose element is @c NULL are performed through the @c read callback,
+	  * which makes it possible to mix plain RAM/ROM with I/O regions. */
+
+	zuint8 const *read_pages[256];
+
+	/** Direct write access to memory, one element per 256-byte page.
+	  * @details Each element points to the 256 bytes of host memory that
+	  * back the corresponding page of the address space. Writes to pages
+	  * whose element is @c NULL are performed through the @c write callback,
+	  * so ROM pages should be left @c NULL here. */
+
+	zuint8 *write_pages[256];
+
+#endif
+
+#ifdef CPU_6502_WITH_REGISTER_CACHE
+
+	/** Whether the callbacks need a coherent view of the CPU state.
+	  * @details @c m6502_run keeps the registers and the cycle counter in
+	  * local variables and writes them back to @c state and @c cycles
+	  * before returning. If this variable is @c TRUE, they are also
+	  * written back before calling @c read, @c write or @c fetch, so the
+	  * callbacks can inspect them; otherwise, the callbacks must not rely
+	  * on the contents of @c state (except for the interrupt flags) or
+	  * @c cycles.
+	  * In both cases, the callbacks must not modify the registers. */
+
+	zboolean coherent_state;
+
+#endif
+
+#ifdef CPU_6502_WITH_DECODE_CACHE
+
+	/** Cache of pre-decoded instructions, or @c NULL to disable it.
+	  * @details Only the instructions located in pages that are directly
+	  * readable through @c read_pages are cached. Writes performed by the
+	  * CPU invalidate the affected page automatically, but if the host
+	  * changes the contents of a cached page or remaps it, it must call
+	  * @c m6502_invalidate_code. */
+
+	M6502DecodeCache *decode_cache;
+
+#endif
+
+#ifdef CPU_6502_WITH_DECIMAL_TABLES
+
+	/** Decimal mode lookup tables used by @c adc and @c sbc.
+	  * @details They must have been filled with
+	  * @c m6502_build_decimal_tables before the CPU executes @c adc or
+	  * @c sbc with the D flag set. */
+
+	M6502DecimalTables const *decimal_tables;
+
+#endif
+
+#ifdef CPU_6502_WITH_LAZY_FLAGS
+
+	/** Pending result from which the N and Z flags are derived.
+	  * @details This variable is used internally by @c m6502_run and its
+	  * value is meaningless outside of it. While @c m6502_run is being
+	  * executed, the N and Z bits of @c state.p are not kept up to date,
+	  * so the callbacks must use @c m6502_flush_flags to read them. */
+
+	zuint16 lazy_nz;
+
+#endif
+
+#ifdef CPU_6502_WITH_HOOKS
+
+	/** Hooks that report the execution, or @c NULL to disable them.
+	  * @details When this variable is @c NULL, @c m6502_run executes a
+	  * copy of the interpreter that contains no calls to the hooks. The
+	  * hooks must not modify the registers, and this variable must not be
+	  * changed during the execution of @c m6502_run. */
+
+	M6502Hooks const *hooks;
+
+#endif
+
+#ifdef CPU_6502_WITH_TRACE
+
+	/** Execution trace writer, or @c NULL to disable tracing.
+	  * @details While it is not @c NULL, @c m6502_run appends a record to
+	  * the trace after each instruction it executes. The interrupt
+	  * responses do not produce records. */
+
+	M6502Trace *trace;
+
+#endif
+
+#ifdef CPU_6502_WITH_BREAKPOINTS
+
+	/** Breakpoints and watchpoints, or @c NULL to disable them.
+	  * @details When this variable and @c hooks are @c NULL, @c m6502_run
+	  * executes the copy of the interpreter that contains no checks. */
+
+	M6502Breakpoints *breakpoints;
+
+#endif
+
+#ifdef CPU_6502_WITH_PROFILER
+
+	/** Execution profile, or @c NULL to disable profiling.
+	  * @details While it is not @c NULL, @c m6502_run adds each instruction
+	  * it executes to the counters of the profile. */
+
+	M6502Profile *profile;
+
+#endif
+
+#ifdef CPU_6502_WITH_RUN_UNTIL
+
+	/** Stop conditions of the current call to @c m6502_run_until.
+	  * @details This is an internal private variable. */
+
+	M6502Until *until;
+
+#endif
+
+#ifdef CPU_6502_WITH_COPY_ON_WRITE
+
+	/** Callback: Called when the CPU needs to write to a page that has an
+	  * element in @c read_pages but not in @c write_pages.
+	  * @details This is where the host implements copy-on-write: if the page
+	  * is shared with other instances, the callback should return a private
+	  * copy of it, or the page itself if no other instance references it
+	  * anymore. The emulator maps the returned page for reading and writing
+	  * and performs the write on it. If the callback returns @c NULL (e.g.
+	  * the page is ROM), the write is performed through @c write.
+	  * @param context The value of the member @c context.
+	  * @param page The index of the 256-byte page.
+	  * @return A pointer to the 256 bytes of host memory to use for the page
+	  * from now on, or @c NULL. */
+
+	zuint8 *(* copy_page)(void *context, zuint8 page);
+
+#endif
+
+#ifdef CPU_6502_WITH_EVENTS
+
+	/** Storage for the event queue.
+	  * @details An array of @c event_capacity elements provided by the host.
+	  * Its contents are managed by the emulator. */
+
+	M6502Event *events;
+
+	/** Number of elements in @c events. */
+
+	zusize event_capacity;
+
+	/** Number of events currently scheduled.
+	  * @details The host sets it to @c 0 to clear the queue. */
+
+	zusize event_count;
+
+	/** Number of cycles elapsed since the host last set this variable.
+	  * @details This is the clock against which the events are scheduled.
+	  * @c m6502_run advances it before returning; during the execution,
+	  * the current time is <tt>event_clock + cycles</tt>. */
+
+	zusize event_clock;
+
+#endif
+
+#ifdef CPU_6502_WITH_CYCLE_EXACT
+
+	/** Interrupt lines sampled before the last cycle of the current
+	  * instruction.
+	  * @details This is an internal private variable. */
+
+	zuint8 interrupt_poll;
+
+#endif
+
+#ifdef CPU_6502_WITH_RECORD_REPLAY
+
+	/** Ring buffer where the bus traffic and interrupt timing are recorded
+	  * or from where they are replayed.
+	  * @details The log contains the values read from the pages selected in
+	  * @c logged_pages and the NMI/IRQ events with their cycle timestamps.
+	  * During a replay, the values are taken from the log instead of calling
+	  * @c read, and @c m6502_nmi and @c m6502_irq have no effect. The CPU
+	  * state at the beginning of a replay must be the same as it was at the
+	  * beginning of the recording (see @c m6502_save). */
+
+	zuint8 *log;
+
+	/** Size of @c log in bytes. */
+
+	zusize log_size;
+
+	/** Index of the next byte of @c log to be written or read.
+	  * @details The host sets it to the beginning of the data before
+	  * starting a recording or a replay. */
+
+	zusize log_index;
+
+	/** Number of cycles elapsed since the beginning of the recording or
+	  * replay.
+	  * @details The host sets it to @c 0 before starting a recording or a
+	  * replay, and @c m6502_run advances it. */
+
+	zusize log_clock;
+
+	/** Bitmap of the 256-byte pages whose reads are recorded.
+	  * @details Bit @c n % 8 of element @c n / 8 corresponds to page @c n. */
+
+	zuint8 logged_pages[256 / 8];
+
+	/** @c M6502_LOG_MODE_OFF, @c M6502_LOG_MODE_RECORD or
+	  * @c M6502_LOG_MODE_REPLAY. */
+
+	zuint8 log_mode;
+
+	/** Last state of the IRQ line written to the log.
+	  * @details This is an internal private variable. */
+
+	zuint8 log_irq;
+
+#endif
 } M6502;
 
 Z_C_SYMBOLS_BEGIN
@@ -122,6 +707,28 @@ CPU_6502_API void m6502_reset(M6502 *object);
 
 CPU_6502_API zusize m6502_run(M6502 *object, zusize cycles);
 
+/** Executes one instruction or the acceptance of an interrupt.
+  * @param object A pointer to a 6502 emulator instance.
+  * @return The number of cycles executed. */
+
+CPU_6502_API zusize m6502_step(M6502 *object);
+
+#ifdef CPU_6502_WITH_RUN_UNTIL
+
+	/** Runs the CPU for a given number of @p cycles or until a stop
+	  * condition is met.
+	  * @details The conditions are checked in the copy of @c m6502_run that
+	  * calls the hooks. The condition that stopped the execution is stored
+	  * in the member @c reason of @p until.
+	  * @param object A pointer to a 6502 emulator instance.
+	  * @param cycles The number of cycles to be executed.
+	  * @param until The stop conditions.
+	  * @return The number of cycles executed. */
+
+	CPU_6502_API zusize m6502_run_until(M6502 *object, zusize cycles, M6502Until *until);
+
+#endif
+
 /** Performs a non-maskable interrupt (NMI).
   * @details This is equivalent to a pulse on the NMI line of a real 6502.
   * @param object A pointer to a 6502 emulator instance. */
@@ -135,6 +742,156 @@ CPU_6502_API void m6502_nmi(M6502 *object);
 
 CPU_6502_API void m6502_irq(M6502 *object, zboolean state);
 
+#ifdef CPU_6502_WITH_EVENTS
+
+	/** Schedules a callback at a given cycle.
+	  * @details @c m6502_run calls it at the first instruction boundary at
+	  * which <tt>event_clock + cycles</tt> is greater than or equal to
+	  * @p cycle. Events due at the same boundary are called in order of
+	  * @p cycle. The callback can schedule new events and change the state
+	  * of the interrupt lines.
+	  * @param object A pointer to a 6502 emulator instance.
+	  * @param cycle The value of @c event_clock at which the event is due.
+	  * @param callback The function to be called. It receives the value of
+	  * the member @c context and @p cycle.
+	  * @return @c TRUE on success; @c FALSE if the queue is full. */
+
+	CPU_6502_API zboolean m6502_schedule(M6502 *object, zusize cycle, void (* callback)(void *context, zusize cycle));
+
+#endif
+
+#ifdef CPU_6502_WITH_COPY_ON_WRITE
+
+	/** Clones a CPU so that both instances share their memory pages until
+	  * one of them writes to them.
+	  * @details @p clone becomes a copy of @p object, and all elements of
+	  * @c write_pages are cleared in both instances, so the next write to
+	  * each page goes through @c copy_page. The host is responsible for
+	  * reference-counting the shared pages and for assigning a different
+	  * @c context to @p clone, if needed. The decode cache, if any, is not
+	  * shared: @c decode_cache is set to @c NULL in @p clone.
+	  * @param object A pointer to the 6502 emulator instance to fork.
+	  * @param clone A pointer to the 6502 emulator instance to initialize. */
+
+	CPU_6502_API void m6502_fork(M6502 *object, M6502 *clone);
+
+#endif
+
+/** Gets the size of a snapshot.
+  * @return The number of bytes written by @c m6502_save and read by
+  * @c m6502_load. */
+
+CPU_6502_API zusize m6502_snapshot_size(void);
+
+/** Saves the CPU state into a snapshot.
+  * @details The snapshot includes the registers, the interrupt flags, the
+  * private temporaries (including @c interrupt_poll) and @c cycles, in a
+  * versioned format that does not depend on the endianness of the host.
+  * @param object A pointer to a 6502 emulator instance.
+  * @param snapshot A buffer of at least @c m6502_snapshot_size() bytes. */
+
+CPU_6502_API void m6502_save(M6502 const *object, zuint8 *snapshot);
+
+/** Restores the CPU state from a snapshot.
+  * @details The callbacks and the rest of the configuration members of the
+  * object are not modified.
+  * @param object A pointer to a 6502 emulator instance.
+  * @param snapshot A snapshot created by @c m6502_save.
+  * @return @c TRUE on success; @c FALSE if the snapshot format version is
+  * not supported, in which case the object is not modified. */
+
+CPU_6502_API zboolean m6502_load(M6502 *object, zuint8 const *snapshot);
+
+#ifdef CPU_6502_WITH_DECODE_CACHE
+
+	/** Discards the pre-decoded instructions that overlap a memory page.
+	  * @details The host must call this function after changing the contents
+	  * of a page behind the CPU's back (e.g. by DMA) or after changing its
+	  * element in @c read_pages (e.g. by bank switching).
+	  * @param object A pointer to a 6502 emulator instance.
+	  * @param page The index of the 256-byte page. */
+
+	CPU_6502_API void m6502_invalidate_code(M6502 *object, zuint8 page);
+
+#endif
+
+#ifdef CPU_6502_WITH_DECIMAL_TABLES
+
+	/** Fills the decimal mode lookup tables.
+	  * @details The results depend only on the CPU variant the emulator
+	  * has been built for, so the tables need to be built only once.
+	  * @param tables A pointer to the tables to fill. */
+
+	CPU_6502_API void m6502_build_decimal_tables(M6502DecimalTables *tables);
+
+#endif
+
+#ifdef CPU_6502_WITH_LAZY_FLAGS
+
+	/** Brings the N and Z flags of @c state.p up to date.
+	  * @details This function is meant to be called from the callbacks,
+	  * since @c m6502_run only updates those flags before returning.
+	  * @param object A pointer to a 6502 emulator instance.
+	  * @return The value of the P register. */
+
+	CPU_6502_API zuint8 m6502_flush_flags(M6502 *object);
+
+#endif
+
+#ifdef CPU_6502_WITH_TRACE
+
+	/** Passes the records written to the current buffer of the trace to
+	  * the @c flush callback, even if the buffer is not full.
+	  * @details The host must call this function when it stops tracing.
+	  * @param object A pointer to a 6502 emulator instance. */
+
+	CPU_6502_API void m6502_trace_flush(M6502 *object);
+
+	/** Decodes one record of an execution trace.
+	  * @details The records are delta-encoded, so @p record must contain
+	  * the previous record of the buffer, or be cleared to zero before
+	  * decoding the first record of a buffer.
+	  * @param record A pointer to the previous record, which is replaced by
+	  * the decoded one.
+	  * @param data A pointer to the encoded record.
+	  * @param size The number of bytes available at @p data.
+	  * @return The size of the encoded record, or @c 0 if @p data does not
+	  * contain a complete record, in which case @p record is not modified. */
+
+	CPU_6502_API zusize m6502_trace_decode(M6502TraceRecord *record, zuint8 const *data, zusize size);
+
+#endif
+
+#ifdef CPU_6502_WITH_PROFILER
+
+	/** Copies the counters of the profile.
+	  * @details The counters of an interval can be obtained by subtracting
+	  * the snapshots taken at its start and at its end.
+	  * @param object A pointer to a 6502 emulator instance.
+	  * @param snapshot A pointer to the object that receives the copy. */
+
+	CPU_6502_API void m6502_profile_snapshot(M6502 const *object, M6502Profile *snapshot);
+
+	/** Clears the counters of the profile to zero.
+	  * @param object A pointer to a 6502 emulator instance. */
+
+	CPU_6502_API void m6502_profile_reset(M6502 *object);
+
+	/** Converts the address histogram of a profile to text in the folded
+	  * stack format used by flame graph tools.
+	  * @details Each address executed at least once produces a line with
+	  * its page and the address itself as frames, followed by the number
+	  * of hits (e.g. "C0xx;C0A3 1234"). The text is not null-terminated.
+	  * @param profile A pointer to the profile.
+	  * @param buffer A pointer to the buffer that receives the text.
+	  * @param size The size of @p buffer in bytes.
+	  * @return The size of the whole text, which has only been written if
+	  * it is less than or equal to @p size. */
+
+	CPU_6502_API zusize m6502_profile_export(M6502Profile const *profile, char *buffer, zusize size);
+
+#endif
+
 Z_C_SYMBOLS_END
 
 #ifdef CPU_6502_WITH_ABI
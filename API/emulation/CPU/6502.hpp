@@ -0,0 +1,228 @@
+/*      ____ ______ ______  ____
+       /  _//\  __//\  __ \/\_, \
+ ____ /\  __ \\___  \\ \/\ \//  /__ ___________________________________________
+|     \ \_____\\____/ \_____\\_____\                                           |
+|  MOS \/_____//___/ \/_____//_____/ CPU Emulator                              |
+|  Copyright (C) 1999-2025 Manuel Sainz de Baranda y Goñi.                     |
+|                                                                              |
+|  This emulator is free software: you can redistribute it and/or modify it    |
+|  under the terms of the GNU Lesser General Public License as published by    |
+|  the Free Software Foundation, either version 3 of the License, or (at your  |
+|  option) any later version.                                                  |
+|                                                                              |
+|  This emulator is distributed in the hope that it will be useful, but        |
+|  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY  |
+|  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public      |
+|  License for more details.                                                   |
+|                                                                              |
+|  You should have received a copy of the GNU Lesser General Public License    |
+|  along with this emulator. If not, see <http://www.gnu.org/licenses/>.       |
+|                                                                              |
+'=============================================================================*/
+
+
+#ifndef _emulation_CPU_6502_HPP_
+#define _emulation_CPU_6502_HPP_
+
+#ifdef CPU_6502_USE_LOCAL_HEADER
+#	include "6502.h"
+#else
+#	include <emulation/CPU/6502.h>
+#endif
+
+#define READ_8(address)		bus->read((zuint16)(address))
+#define WRITE_8(address, value) bus->write((zuint16)(address), (zuint8)(value))
+#define READ_16(address)	read_16bit((zuint16)(address))
+#define PUSH_16(value)		push_16bit((zuint16)(value))
+#define POP_16			pop_16bit()
+#define DONE(cycles)		instruction_cycles = cycles; break
+#define EXTRA_CYCLE		CYCLES++;
+
+#ifdef CPU_6502_USE_LOCAL_HEADER
+#	include "6502-semantics.h"
+#else
+#	include <emulation/CPU/6502-semantics.h>
+#endif
+
+/** 6502 emulator instance with a statically bound bus.
+  * @details This is a header-only C++ front end that executes the same
+  * instruction semantics as @c m6502_run with the switch dispatch, but
+  * accesses memory through an object of type @p Bus instead of the @c read
+  * and @c write callbacks, so that the compiler can inline the memory map of
+  * the host. @p Bus must provide the member functions
+  * <tt>zuint8 read(zuint16 address)</tt> and
+  * <tt>void write(zuint16 address, zuint8 value)</tt>, which can be static.
+  * All the members of @c M6502 are inherited and have the same meaning, but
+  * only @c cycles, @c state, @c interrupt_pending, @c jammed, @c lazy_nz and
+  * @c decimal_tables are used. The emulator variant and the options
+  * @c CPU_6502_WITH_DECIMAL_TABLES, @c CPU_6502_WITH_LAZY_FLAGS and
+  * @c CPU_6502_WITH_UNDOCUMENTED_OPCODES are honored; the remaining options
+  * only affect the C implementation. */
+
+template <class Bus> class M6502Core : public M6502 {
+	public:
+
+	/** Pointer to the bus used to access the memory. */
+
+	Bus *bus;
+
+	/** Constructs a 6502 emulator instance.
+	  * @details All the inherited members are cleared to zero.
+	  * @param host_bus A pointer to the bus. */
+
+	explicit M6502Core(Bus *host_bus) : M6502(), bus(host_bus) {}
+
+	/** Changes the CPU power status.
+	  * @details Equivalent to @c m6502_power.
+	  * @param on @c TRUE = power ON; @c FALSE = power OFF. */
+
+	void power(zboolean on)
+		{
+		M6502 *object = this;
+
+		if (on)
+			{
+			PC = Z_6502_VALUE_AFTER_POWER_ON_PC;
+			S  = Z_6502_VALUE_AFTER_POWER_ON_S;
+			P  = Z_6502_VALUE_AFTER_POWER_ON_P;
+			A  = Z_6502_VALUE_AFTER_POWER_ON_A;
+			X  = Z_6502_VALUE_AFTER_POWER_ON_X;
+			Y  = Z_6502_VALUE_AFTER_POWER_ON_Y;
+			IRQ = NMI = FALSE;
+			}
+
+		else PC = S = P = A = X = Y = IRQ = NMI = 0;
+
+#		ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+			JAMMED = FALSE;
+#		endif
+		}
+
+	/** Resets the CPU.
+	  * @details Equivalent to @c m6502_reset. */
+
+	void reset()
+		{
+		M6502 *object = this;
+
+		PC = READ_POINTER(RESET);
+		S = Z_6502_VALUE_AFTER_POWER_ON_S;
+		P = Z_6502_VALUE_AFTER_POWER_ON_P;
+		IRQ = NMI = FALSE;
+
+#		ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+			JAMMED = FALSE;
+#		endif
+		}
+
+	/** Runs the CPU for a given number of cycles.
+	  * @details Equivalent to @c m6502_run.
+	  * @param budget The number of cycles to be executed.
+	  * @return The number of cycles executed. */
+
+	zusize run(zusize budget)
+		{
+		M6502	*object = this;
+		zuint16 address;
+		zuint8	penalty, instruction_cycles;
+
+		CYCLES = 0;
+		PENDING = TRUE;
+		NZ_FROM_P
+
+		while (CYCLES < budget)
+			{
+			if (PENDING)
+				{
+				if (NMI && !JAMMED)
+					{
+					NMI = FALSE;
+					ACCEPT_INTERRUPT(READ_POINTER(NMI))
+					continue;
+					}
+
+				if (IRQ && !(P & IP) && !JAMMED)
+					{
+					ACCEPT_INTERRUPT(READ_POINTER(IRQ))
+					continue;
+					}
+
+				PENDING = FALSE;
+				}
+
+			SWITCH_DISPATCH
+			CYCLES += instruction_cycles;
+			}
+
+		P_FROM_NZ
+		return CYCLES;
+		}
+
+	/** Performs a non-maskable interrupt (NMI).
+	  * @details Equivalent to @c m6502_nmi. */
+
+	void nmi()
+		{
+		M6502 *object = this;
+
+		NMI = PENDING = TRUE;
+		}
+
+	/** Changes the state of the maskable interrupt (IRQ).
+	  * @details Equivalent to @c m6502_irq.
+	  * @param line @c TRUE = line high; @c FALSE = line low. */
+
+	void irq(zboolean line)
+		{
+		M6502 *object = this;
+
+		IRQ = line;
+		PENDING = TRUE;
+		}
+
+	private:
+
+	zuint16 read_16bit(zuint16 address)
+		{return (zuint16)(READ_8(address) | (zuint16)READ_8(address + 1) << 8);}
+
+
+	void push_16bit(zuint16 value)
+		{
+		M6502 *object = this;
+
+		WRITE_8(Z_6502_ADDRESS_STACK | S, value >> 8);
+		WRITE_8(Z_6502_ADDRESS_STACK | (zuint8)(S - 1), value);
+		S -= 2;
+		}
+
+
+	zuint16 pop_16bit()
+		{
+		M6502 *object = this;
+		zuint16 result = (zuint16)
+		(	    READ_8(Z_6502_ADDRESS_STACK | (zuint8)(S + 1)) |
+		 (((zuint16)READ_8(Z_6502_ADDRESS_STACK | (zuint8)(S + 2))) << 8));
+
+		S += 2;
+		return result;
+		}
+};
+
+#define CPU_6502_SEMANTICS_UNDEFINE
+
+#ifdef CPU_6502_USE_LOCAL_HEADER
+#	include "6502-semantics.h"
+#else
+#	include <emulation/CPU/6502-semantics.h>
+#endif
+
+#undef CPU_6502_SEMANTICS_UNDEFINE
+#undef READ_8
+#undef WRITE_8
+#undef READ_16
+#undef PUSH_16
+#undef POP_16
+#undef DONE
+#undef EXTRA_CYCLE
+
+#endif /* _emulation_CPU_6502_HPP_ */
@@ -7,7 +7,7 @@ solution "6502"
 	project "6502"
 		language "C"
 		flags {"ExtraWarnings"}
-		files {"../sources/**.c"}
+		files {"../sources/6502.c"}
 		includedirs {"../API"}
 		--buildoptions {"-std=c89 -pedantic -Wall -Weverything"}
 
@@ -31,3 +31,74 @@ solution "6502"
 
 		configuration "*static-module"
 			defines {"CPU_6502_WITH_ABI"}
+
+	project "6502-farm"
+		language "C"
+		kind "StaticLib"
+		flags {"ExtraWarnings"}
+		files {"../sources/6502-farm.c"}
+		includedirs {"../API"}
+		defines {"CPU_6502_STATIC"}
+		links {"pthread"}
+
+		configuration "release*"
+			targetdir "lib/release"
+			flags {"Optimize"}
+
+		configuration "debug*"
+			targetdir "lib/debug"
+			flags {"Symbols"}
+
+	project "benchmark-6502"
+		language "C"
+		kind "ConsoleApp"
+		flags {"ExtraWarnings"}
+		files {"../sources/benchmark-6502.c", "../sources/6502.c"}
+		includedirs {"../API"}
+		defines {"CPU_6502_STATIC"}
+
+		configuration "release*"
+			targetdir "bin/release"
+			flags {"Optimize"}
+
+		configuration "debug*"
+			targetdir "bin/debug"
+			flags {"Symbols"}
+
+	project "trace-6502"
+		language "C"
+		kind "ConsoleApp"
+		flags {"ExtraWarnings"}
+		files {"../sources/trace-6502.c", "../sources/6502.c"}
+		includedirs {"../API"}
+		defines {"CPU_6502_STATIC", "CPU_6502_WITH_TRACE"}
+
+		configuration "release*"
+			targetdir "bin/release"
+			flags {"Optimize"}
+
+		configuration "debug*"
+			targetdir "bin/debug"
+			flags {"Symbols"}
+
+	for _, variant in ipairs {"", "65C02", "2A03"} do
+		project ("test-decimal-tables-6502" .. (variant ~= "" and "-" .. variant:lower() or ""))
+			language "C"
+			kind "ConsoleApp"
+			flags {"ExtraWarnings"}
+			files {"../sources/test-decimal-tables-6502.c", "../sources/6502.c"}
+			includedirs {"../API"}
+			defines {"CPU_6502_STATIC", "CPU_6502_WITH_DECIMAL_TABLES"}
+
+			if variant ~= "" then
+				defines {"CPU_6502_VARIANT_" .. variant}
+			end
+
+			configuration "release*"
+				targetdir "bin/release"
+				flags {"Optimize"}
+
+			configuration "debug*"
+				targetdir "bin/debug"
+				flags {"Symbols"}
+	end
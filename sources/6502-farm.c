@@ -0,0 +1,240 @@
+/* vim: set tabstop=8 noexpandtab: */
+/*      ____ ______ ______  ____
+       /  _//\  __//\  __ \/\_, \
+ ____ /\  __ \\___  \\ \/\ \//  /__ ___________________________________________
+|     \ \_____\\____/ \_____\\_____\                                           |
+|  MOS \/_____//___/ \/_____//_____/ CPU Emulator - Farm                       |
+|  Copyright (C) 1999-2025 Manuel Sainz de Baranda y Goñi.                     |
+|                                                                              |
+|  This emulator is free software: you can redistribute it and/or modify it    |
+|  under the terms of the GNU Lesser General Public License as published by    |
+|  the Free Software Foundation, either version 3 of the License, or (at your  |
+|  option) any later version.                                                  |
+|                                                                              |
+|  This emulator is distributed in the hope that it will be useful, but        |
+|  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY  |
+|  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public      |
+|  License for more details.                                                   |
+|                                                                              |
+|  You should have received a copy of the GNU Lesser General Public License    |
+|  along with this emulator. If not, see <http://www.gnu.org/licenses/>.       |
+|                                                                              |
+'=============================================================================*/
+
+/*----------------------------------------------------------------------------.
+| Unlike 6502.c, this file uses POSIX threads and the C standard library. It  |
+| must be compiled with the same configuration macros as 6502.c, since it     |
+| accesses the members of M6502.					      |
+'----------------------------------------------------------------------------*/
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#ifdef CPU_6502_DEPENDENCIES_H
+#	include CPU_6502_DEPENDENCIES_H
+#else
+#	include <Z/hardware/CPU/architecture/6502.h>
+#endif
+
+#ifdef CPU_6502_USE_LOCAL_HEADER
+#	include "6502-farm.h"
+#else
+#	include <emulation/CPU/6502-farm.h>
+#endif
+
+
+/*----------------------------------------------------------------------------.
+| The queues are singly linked lists threaded through the `next` array of the |
+| farm, so each CPU can be in the queue of any thread without extra storage.  |
+| `count` is used as the null link. All the queues and counters are protected |
+| by the mutex, which is only taken once per slice.			      |
+'----------------------------------------------------------------------------*/
+
+typedef struct {
+	zusize first;
+	zusize last;
+} Queue;
+
+
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t	condition;
+	M6502*		objects;
+	zusize*		budgets;
+	zusize*		next;
+	Queue*		queues;
+	zusize		count;
+	zusize		slice;
+	zusize		remaining;
+	zuint		threads;
+	void*		context;
+	void		(* completed)(void *context, M6502 *object);
+} Farm;
+
+
+typedef struct {
+	Farm*	  farm;
+	zuint	  index;
+	pthread_t thread;
+} Worker;
+
+
+static void push(Farm *farm, zuint queue_index, zusize index)
+	{
+	Queue *queue = &farm->queues[queue_index];
+
+	farm->next[index] = farm->count;
+	if (queue->first == farm->count) queue->first = index;
+	else farm->next[queue->last] = index;
+	queue->last = index;
+	}
+
+
+/*-----------------------------------------------------------.
+| Takes the first CPU of the worker's own queue or, if it is |
+| empty, the first CPU of the queue of the next busy worker. |
+'-----------------------------------------------------------*/
+
+static zboolean take(Farm *farm, zuint worker_index, zusize *index)
+	{
+	Queue *queue;
+	zuint  offset;
+
+	for (offset = 0; offset < farm->threads; offset++)
+		{
+		queue = &farm->queues[(worker_index + offset) % farm->threads];
+
+		if (queue->first != farm->count)
+			{
+			*index = queue->first;
+			queue->first = farm->next[queue->first];
+			return TRUE;
+			}
+		}
+
+	return FALSE;
+	}
+
+
+static void *work(void *argument)
+	{
+	Worker*	 worker = argument;
+	Farm*	 farm	= worker->farm;
+	M6502*	 object;
+	zusize	 index, cycles;
+	zboolean done;
+
+	pthread_mutex_lock(&farm->mutex);
+
+	while (farm->remaining)
+		{
+		if (!take(farm, worker->index, &index))
+			{
+			pthread_cond_wait(&farm->condition, &farm->mutex);
+			continue;
+			}
+
+		pthread_mutex_unlock(&farm->mutex);
+		object = &farm->objects[index];
+
+		cycles = m6502_run(
+			object,
+			farm->slice && farm->slice < farm->budgets[index]
+				? farm->slice : farm->budgets[index]);
+
+		farm->budgets[index] = cycles < farm->budgets[index] ? farm->budgets[index] - cycles : 0;
+		done = !farm->budgets[index];
+
+#		ifdef CPU_6502_WITH_BREAKPOINTS
+			if (object->breakpoints != NULL && object->breakpoints->reason != M6502_BREAK_NONE)
+				done = TRUE;
+#		endif
+
+		if (done && farm->completed != NULL) farm->completed(farm->context, object);
+		pthread_mutex_lock(&farm->mutex);
+
+		if (!done)
+			{
+			push(farm, worker->index, index);
+			pthread_cond_signal(&farm->condition);
+			}
+
+		else if (!--farm->remaining) pthread_cond_broadcast(&farm->condition);
+		}
+
+	pthread_mutex_unlock(&farm->mutex);
+	return NULL;
+	}
+
+
+CPU_6502_API zboolean m6502_farm_run(M6502 *objects, zusize *budgets, zusize count, zusize slice, zuint threads, void *context, void (* completed)(void *context, M6502 *object))
+	{
+	Farm	farm;
+	Worker* workers;
+	zusize	index;
+	zuint	started;
+
+	if (!count) return TRUE;
+	if (!threads) threads = 1;
+	if (threads > count) threads = (zuint)count;
+
+	farm.next    = malloc(count * sizeof(zusize));
+	farm.queues  = malloc(threads * sizeof(Queue));
+	workers	     = malloc(threads * sizeof(Worker));
+
+	if (farm.next == NULL || farm.queues == NULL || workers == NULL)
+		{
+		free(farm.next);
+		free(farm.queues);
+		free(workers);
+		return FALSE;
+		}
+
+	farm.objects   = objects;
+	farm.budgets   = budgets;
+	farm.count     = count;
+	farm.slice     = slice;
+	farm.remaining = 0;
+	farm.threads   = threads;
+	farm.context   = context;
+	farm.completed = completed;
+
+	for (started = 0; started < threads; started++)
+		farm.queues[started].first = count;
+
+	/*------------------------------------------------------.
+	| The CPUs with budget are dealt out among the workers. |
+	| A worker that finishes its own CPUs steals the rest.	|
+	'------------------------------------------------------*/
+	for (index = 0; index < count; index++) if (budgets[index])
+		push(&farm, (zuint)(farm.remaining++ % threads), index);
+
+	pthread_mutex_init(&farm.mutex, NULL);
+	pthread_cond_init(&farm.condition, NULL);
+
+	for (started = 0; started < threads; started++)
+		{
+		workers[started].farm  = &farm;
+		workers[started].index = started;
+
+		if (started && pthread_create(&workers[started].thread, NULL, work, &workers[started]))
+			break;
+		}
+
+	/*----------------------------------------------------.
+	| If a thread cannot be created, its queue is emptied |
+	| by the others, so the farm just runs with fewer.    |
+	'----------------------------------------------------*/
+	work(&workers[0]);
+	while (--started) pthread_join(workers[started].thread, NULL);
+
+	pthread_cond_destroy(&farm.condition);
+	pthread_mutex_destroy(&farm.mutex);
+	free(farm.next);
+	free(farm.queues);
+	free(workers);
+	return TRUE;
+	}
+
+
+/* 6502-farm.c EOF */
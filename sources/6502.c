@@ -33,6 +33,31 @@
 #	define CPU_6502_WITH_ABI
 #endif
 
+#if (	defined(CPU_6502_WITH_REGISTER_CACHE) || defined(CPU_6502_WITH_DECODE_CACHE) || \
+	defined(CPU_6502_WITH_LAZY_FLAGS)     || defined(CPU_6502_WITH_HOOKS)	     || \
+	defined(CPU_6502_WITH_TRACE)	      || defined(CPU_6502_WITH_BREAKPOINTS)  || \
+	defined(CPU_6502_WITH_RUN_UNTIL)      || defined(CPU_6502_WITH_PROFILER)     || \
+	defined(CPU_6502_WITH_FETCH))						     && \
+	!defined(CPU_6502_WITH_SWITCH_DISPATCH)
+#	define CPU_6502_WITH_SWITCH_DISPATCH
+#endif
+
+#if defined(CPU_6502_WITH_CYCLE_EXACT) && (		\
+	defined(CPU_6502_WITH_SWITCH_DISPATCH) ||	\
+	defined(CPU_6502_WITH_RECORD_REPLAY)   ||	\
+	defined(CPU_6502_WITH_FAST_FORWARD))
+#	error "CPU_6502_WITH_CYCLE_EXACT is incompatible with the switch dispatch, record/replay and fast-forward options"
+#endif
+
+#if defined(CPU_6502_VARIANT_2A03) && defined(CPU_6502_VARIANT_65C02)
+#	error "CPU_6502_VARIANT_2A03 and CPU_6502_VARIANT_65C02 are mutually exclusive"
+#endif
+
+#if defined(CPU_6502_VARIANT_65C02) && \
+	(defined(CPU_6502_WITH_UNDOCUMENTED_OPCODES) || defined(CPU_6502_WITH_CYCLE_EXACT))
+#	error "CPU_6502_VARIANT_65C02 is incompatible with the undocumented opcodes and cycle-exact options"
+#endif
+
 #ifdef CPU_6502_WITH_ABI
 #	if defined(CPU_6502_HIDE_ABI)
 #		define CPU_6502_ABI static
@@ -59,67 +84,183 @@ typedef void   (* WriteEA    )(M6502 *object, zuint8 value);
 
 /* MARK: - Macros & Functions: Callback */
 
-#define READ_8(address) \
-	object->read (object->context, (zuint16)(address))
+#ifdef CPU_6502_WITH_RECORD_REPLAY
 
-#define WRITE_8(address, value) \
-	object->write(object->context, (zuint16)(address), (zuint8)(value))
+	/*--------------------------------------------------------------.
+	| Log records:							|
+	| 0, value		 Value read from a logged page.		|
+	| 1, clock (8 bytes LE)	 NMI accepted.				|
+	| 2, clock (8 bytes LE)	 IRQ line changed to low.		|
+	| 3, clock (8 bytes LE)	 IRQ line changed to high.		|
+	| The clock is the number of cycles elapsed since the host set	|
+	| `log_clock` to 0, at the instruction boundary where the	|
+	| interrupt line was sampled. After each record, the next byte	|
+	| is set to 0 as an end mark, so that a replay does not apply	|
+	| stale interrupt records found past the end of the log.	|
+	'--------------------------------------------------------------*/
 
+#	define LOG_READ 0
+#	define LOG_NMI	1
+#	define LOG_IRQ	2
 
-static Z_INLINE zuint16 read_16bit(M6502 *object, zuint16 address)
-	{return (zuint16)(READ_8(address) | (zuint16)READ_8(address + 1) << 8);}
 
+	static void log_byte(M6502 *object, zuint8 value)
+		{
+		object->log[object->log_index] = value;
+		if (++object->log_index == object->log_size) object->log_index = 0;
+		}
+
+
+	static zuint8 unlog_byte(M6502 *object)
+		{
+		zuint8 value = object->log[object->log_index];
+
+		if (++object->log_index == object->log_size) object->log_index = 0;
+		return value;
+		}
+
+
+	static zuint8 logged_read(M6502 *object, zuint16 address)
+		{
+		zuint8 value;
 
-#define READ_16( address)	   read_16bit (object, (zuint16)(address))
-#define READ_POINTER(pointer_name) READ_16(Z_6502_ADDRESS_##pointer_name##_POINTER)
+		if (	object->log_mode == M6502_LOG_MODE_OFF ||
+			!(object->logged_pages[address >> 11] & (1U << ((address >> 8) & 7)))
+		)
+			return object->read(object->context, address);
 
+		if (object->log_mode == M6502_LOG_MODE_REPLAY)
+			{
+			(void)unlog_byte(object); /* LOG_READ */
+			return unlog_byte(object);
+			}
+
+		value = object->read(object->context, address);
+		log_byte(object, LOG_READ);
+		log_byte(object, value);
+		object->log[object->log_index] = LOG_READ;
+		return value;
+		}
 
-/* MARK: - Macros: Registers */
 
-#define PC object->state.Z_6502_STATE_MEMBER_PC
-#define S  object->state.Z_6502_STATE_MEMBER_S
-#define P  object->state.Z_6502_STATE_MEMBER_P
-#define A  object->state.Z_6502_STATE_MEMBER_A
-#define X  object->state.Z_6502_STATE_MEMBER_X
-#define Y  object->state.Z_6502_STATE_MEMBER_Y
+#	define READ_CALLBACK(address) logged_read(object, address)
 
+#else
+#	define READ_CALLBACK(address) object->read(object->context, address)
+#endif
 
-/* MARK: - Macros: Internal Bits */
+#ifdef CPU_6502_WITH_DECODE_CACHE
 
-#define NMI object->state.Z_6502_STATE_MEMBER_NMI
-#define IRQ object->state.Z_6502_STATE_MEMBER_IRQ
+	static void invalidate_code(M6502DecodeCache *cache, zuint8 page)
+		{
+		/*----------------------------------------------------------.
+		| Instructions starting in the last 2 bytes of the previous |
+		| page can have their operands in this page.		    |
+		'----------------------------------------------------------*/
+		zuint16 address = (zuint16)((page << 8) - 2);
+		zuint	count	= 256 + 2;
+
+		cache->code_pages[page] = FALSE;
+		while (count--) cache->instructions[address++].valid = FALSE;
+		}
 
 
-/* MARK: - Macros: Temporal Data */
+#	define INVALIDATE_CODE(address)									\
+		(object->decode_cache != NULL &&							\
+		 object->decode_cache->code_pages[(zuint16)(address) >> 8]				\
+			? invalidate_code(object->decode_cache, (zuint8)((zuint16)(address) >> 8))	\
+			: (void)0)
 
-#define CYCLES	  object->cycles
-#define OPCODE	  object->opcode
-#define EA	  object->ea
-#define EA_CYCLES object->ea_cycles
+#endif
 
+#ifdef CPU_6502_WITH_COPY_ON_WRITE
 
-/* MARK: - Macros: Flags */
+	static zboolean copy_on_write(M6502 *object, zuint16 address, zuint8 value)
+		{
+		zuint8 index = (zuint8)(address >> 8);
+		zuint8 *page;
 
-#define NP 128
-#define VP  64
-#define BP  16
-#define DP   8
-#define IP   4
-#define ZP   2
-#define CP   1
+		if (	object->read_pages[index] == NULL ||
+			(page = object->copy_page(object->context, index)) == NULL
+		)
+			return FALSE;
 
-#define NZP  (NP | ZP)
-#define NZCP (NP | ZP | CP)
+		object->read_pages[index] = object->write_pages[index] = page;
+		page[address & 0xFF] = value;
+		return TRUE;
+		}
 
-#define ZP_ZERO( value) (!(value) << 1)
-#define SET_P_NZ(value) P = (P & ~NZP) | ((value) ? ((value) & NP) : ZP)
 
+#	define COPY_ON_WRITE(address, value) copy_on_write(object, address, value)
 
-/* MARK: - Macros & Functions: Stack */
+#else
+#	define COPY_ON_WRITE(address, value) FALSE
+#endif
+
+#ifdef CPU_6502_WITH_PAGE_TABLE
+
+	static Z_INLINE zuint8 read_8bit(M6502 *object, zuint16 address)
+		{
+		zuint8 const *page = object->read_pages[address >> 8];
+
+		return page != NULL
+			? page[address & 0xFF]
+			: READ_CALLBACK(address);
+		}
+
+
+	static Z_INLINE void write_8bit(M6502 *object, zuint16 address, zuint8 value)
+		{
+		zuint8 *page = object->write_pages[address >> 8];
+
+#		ifdef CPU_6502_WITH_DECODE_CACHE
+			INVALIDATE_CODE(address);
+#		endif
+
+		if (page != NULL) page[address & 0xFF] = value;
+
+		else if (!COPY_ON_WRITE(address, value))
+			object->write(object->context, address, value);
+		}
+
+
+#	define BUS_READ_8(address) \
+		read_8bit (object, (zuint16)(address))
+
+#	define BUS_WRITE_8(address, value) \
+		write_8bit(object, (zuint16)(address), (zuint8)(value))
+
+#else
+
+#	define BUS_READ_8(address) \
+		READ_CALLBACK((zuint16)(address))
+
+#	define BUS_WRITE_8(address, value) \
+		object->write(object->context, (zuint16)(address), (zuint8)(value))
+
+#endif
+
+#define READ_8	BUS_READ_8
+#define WRITE_8 BUS_WRITE_8
+
+
+static Z_INLINE zuint16 read_16bit(M6502 *object, zuint16 address)
+	{return (zuint16)(READ_8(address) | (zuint16)READ_8(address + 1) << 8);}
+
+
+#define READ_16(address) read_16bit(object, (zuint16)(address))
+
+
+/* MARK: - Macros: Instruction Semantics */
+
+#ifdef CPU_6502_USE_LOCAL_HEADER
+#	include "6502-semantics.h"
+#else
+#	include <emulation/CPU/6502-semantics.h>
+#endif
 
-#define PUSH_8(value) WRITE_8(Z_6502_ADDRESS_STACK + S--, value);
-#define POP_8	      READ_8 (Z_6502_ADDRESS_STACK + ++S)
 
+/* MARK: - Macros & Functions: Stack */
 
 static Z_INLINE void push_16bit(M6502 *object, zuint16 value)
 	{
@@ -146,17 +287,39 @@ static Z_INLINE zuint16 pop_16bit(M6502 *object)
 
 /* MARK: - Addressing Helpers */
 
-#define READ_BYTE_OPERAND READ_8 ((PC += 2) - 1)
-#define READ_WORD_OPERAND READ_16((PC += 3) - 2)
+#if defined(CPU_6502_WITH_DECODE_CACHE) || defined(CPU_6502_WITH_FETCH)
+
+	/*----------------------------------------------------------------.
+	| With the decode cache or the fetch callback, m6502_run takes	  |
+	| the operands from the pre-decoded or pre-fetched instruction,	  |
+	| if any. Only the switch dispatch uses these macros, so they can |
+	| refer to its local `instruction`.				  |
+	'----------------------------------------------------------------*/
+
+#	undef BYTE_OPERAND
+#	undef WORD_OPERAND
+#	undef READ_BYTE_OPERAND
+#	undef READ_WORD_OPERAND
+
+#	define DECODED (instruction != NULL && instruction->valid)
 
-#define   ZERO_PAGE_ADDRESS READ_BYTE_OPERAND
-#define ZERO_PAGE_X_ADDRESS (zuint8)(READ_BYTE_OPERAND + X)
-#define ZERO_PAGE_Y_ADDRESS (zuint8)(READ_BYTE_OPERAND + Y)
-#define    ABSOLUTE_ADDRESS READ_WORD_OPERAND
-#define  ABSOLUTE_X_ADDRESS READ_WORD_OPERAND + X
-#define  ABSOLUTE_Y_ADDRESS READ_WORD_OPERAND + Y
-#define  INDIRECT_X_ADDRESS READ_16((zuint8)(READ_BYTE_OPERAND + X))
-#define  INDIRECT_Y_ADDRESS READ_16(READ_BYTE_OPERAND) + Y
+#	define READ_OPERAND_8  READ_8
+#	define READ_OPERAND_16 READ_16
+
+#	define BYTE_OPERAND \
+		(DECODED ? (zuint8)instruction->operand : READ_OPERAND_8(PC + 1))
+
+#	define WORD_OPERAND \
+		(DECODED ? instruction->operand : READ_OPERAND_16(PC + 1))
+
+#	define READ_BYTE_OPERAND \
+		(DECODED ? (PC += 2, (zuint8)instruction->operand) : READ_OPERAND_8((PC += 2) - 1))
+
+#	define READ_WORD_OPERAND \
+		(DECODED ? (PC += 3, instruction->operand) : READ_OPERAND_16((PC += 3) - 2))
+#endif
+
+#if !defined(CPU_6502_WITH_SWITCH_DISPATCH) && !defined(CPU_6502_WITH_CYCLE_EXACT)
 
 #define EA_READER(name) static zuint8 read_##name (M6502 *object)
 #define EA_WRITER(name) static void   write_##name(M6502 *object, zuint8 value)
@@ -171,7 +334,35 @@ EA_READER(indirect_x)	 {EA_CYCLES = 6; return READ_8(INDIRECT_X_ADDRESS      );}
 EA_READER(g_zero_page)	 {EA_CYCLES = 5; return READ_8(EA = ZERO_PAGE_ADDRESS  );}
 EA_READER(g_zero_page_x) {EA_CYCLES = 6; return READ_8(EA = ZERO_PAGE_X_ADDRESS);}
 EA_READER(g_absolute)	 {EA_CYCLES = 6; return READ_8(EA = ABSOLUTE_ADDRESS   );}
-EA_READER(g_absolute_x)	 {EA_CYCLES = 7; return READ_8(EA = ABSOLUTE_X_ADDRESS );}
+
+#ifdef CPU_6502_VARIANT_65C02
+
+	/*-----------------------------------------------------------------.
+	| On the 65C02, asl, lsr, rol and ror with absolute,X addressing   |
+	| save one cycle if the indexing does not cross a page boundary.   |
+	| dec and inc (opcodes C0h and above) always take 7 cycles.	   |
+	'-----------------------------------------------------------------*/
+
+	EA_READER(g_absolute_x)
+		{
+		zuint16 address = READ_WORD_OPERAND;
+
+		EA_CYCLES = OPCODE >= 0xC0 || (address & 0xFF) + X > 255 ? 7 : 6;
+		return READ_8(EA = address + X);
+		}
+
+
+	EA_READER(indirect_zp) {EA_CYCLES = 5; return READ_8(INDIRECT_ZP_ADDRESS);}
+
+#else
+	EA_READER(g_absolute_x)	 {EA_CYCLES = 7; return READ_8(EA = ABSOLUTE_X_ADDRESS );}
+#endif
+
+#ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+	EA_READER(g_absolute_y)	 {EA_CYCLES = 7; return READ_8(EA = ABSOLUTE_Y_ADDRESS );}
+	EA_READER(g_indirect_x)	 {EA_CYCLES = 8; return READ_8(EA = INDIRECT_X_ADDRESS );}
+	EA_READER(g_indirect_y)	 {EA_CYCLES = 8; return READ_8(EA = INDIRECT_Y_ADDRESS );}
+#endif
 
 
 EA_READER(penalized_absolute_x)
@@ -210,6 +401,10 @@ EA_WRITER(absolute_y)  {EA_CYCLES = 5; WRITE_8(ABSOLUTE_Y_ADDRESS,  value);}
 EA_WRITER(indirect_x)  {EA_CYCLES = 6; WRITE_8(INDIRECT_X_ADDRESS,  value);}
 EA_WRITER(indirect_y)  {EA_CYCLES = 6; WRITE_8(INDIRECT_Y_ADDRESS,  value);}
 
+#ifdef CPU_6502_VARIANT_65C02
+	EA_WRITER(indirect_zp) {EA_CYCLES = 5; WRITE_8(INDIRECT_ZP_ADDRESS, value);}
+#endif
+
 
 /* MARK: - J/K Addressing Tables
 
@@ -363,6 +558,70 @@ static WriteEA const write_q_table[6] = {
 };
 
 
+#ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+
+/* MARK: - L/M Addressing Tables
+
+		     .-----------------------------------------------.
+		     | 000 | 001 | 010 | 011 | 100 | 101 | 110 | 111 |
+		     |-----+-----+-----+-----+-----+-----+-----+-----|
+		     | slo | rla | sre | rra | sax | lax | dcp | isc |
+		     |-----+-----+-----+-----+-----+-----+-----+-----|
+		     |	L  |  L	 |  L  |  L  |	M  |  M	 |  L  |  L  |
+.--------------------+-----+-----+-----+-----+-----+-----+-----+-----|
+| 000 | (Indirect,X) |	8  |  8	 |  8  |  8  |	6  |  6	 |  8  |  8  |
+|-----+--------------+-----+-----+-----+-----+-----+-----+-----+-----|
+| 001 | Zero Page    |	5  |  5	 |  5  |  5  |	3  |  3	 |  5  |  5  |
+|-----+--------------+-----+-----+-----+-----+-----+-----+-----+-----|
+| 010 | #Immediate   |	   |	 |     |     |	   | 2 * |     |     |
+|-----+--------------+-----+-----+-----+-----+-----+-----+-----+-----|
+| 011 | Absolute     |	6  |  6	 |  6  |  6  |	4  |  4	 |  6  |  6  |
+|-----+--------------+-----+-----+-----+-----+-----+-----+-----+-----|
+| 100 | (Indirect),Y |	8  |  8	 |  8  |  8  |	   | 5+1 |  8  |  8  |
+|-----+--------------+-----+-----+-----+-----+-----+-----+-----+-----|
+| 101 | Zero Page,XY | 6/x | 6/x | 6/x | 6/x | 4/y | 4/y | 6/x | 6/x |
+|-----+--------------+-----+-----+-----+-----+-----+-----+-----+-----|
+| 110 | Absolute,Y   |	7  |  7	 |  7  |  7  |	   |4+1 *|  7  |  7  |
+|-----+--------------+-----+-----+-----+-----+-----+-----+-----+-----|
+| 111 | Absolute,XY  | 7/x | 7/x | 7/x | 7/x |	   |4+1/y| 7/x | 7/x |
+|-------------------------------------------------------------------|
+| * Used by lxa (AB) and las (BB), which share the M addressing.    |
+'-------------------------------------------------------------------*/
+
+static ReadEA const read_l_table[8] = {
+	/* 8 */ read_g_indirect_x,
+	/* 5 */ read_g_zero_page,
+	/* 0 */ NULL,
+	/* 6 */ read_g_absolute,
+	/* 8 */ read_g_indirect_y,
+	/* 6 */ read_g_zero_page_x,
+	/* 7 */ read_g_absolute_y,
+	/* 7 */ read_g_absolute_x
+};
+
+static ReadEA const read_m_table[8] = {
+	/* 6 */ read_indirect_x,
+	/* 3 */ read_zero_page,
+	/* 2 */ read_immediate,
+	/* 4 */ read_absolute,
+	/* 5 */ read_penalized_indirect_y,
+	/* 4 */ read_zero_page_y,
+	/* 4 */ read_penalized_absolute_y,
+	/* 4 */ read_penalized_absolute_y
+};
+
+static WriteEA const write_m_table[6] = {
+	/* 6 */ write_indirect_x,
+	/* 3 */ write_zero_page,
+	/* 0 */ NULL,
+	/* 4 */ write_absolute,
+	/* 0 */ NULL,
+	/* 4 */ write_zero_page_y
+};
+
+#endif
+
+
 /* MARK: - Macros: Addressing Accessors */
 
 #define EA_INDEX       (OPCODE & 28) >> 2
@@ -374,56 +633,21 @@ static WriteEA const write_q_table[6] = {
 #define WRITE_H(value) write_h_table[EA_INDEX](object, value)
 #define WRITE_Q(value) write_q_table[EA_INDEX](object, value)
 #define WRITE_G(value) if (EA_CYCLES == 2) A = value; else WRITE_8(EA, value);
+#define EXTRA_CYCLE    EA_CYCLES++;
 
+#ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+#	define READ_L	      read_l_table [EA_INDEX](object)
+#	define READ_M	      read_m_table [EA_INDEX](object)
+#	define WRITE_L(value) WRITE_8(EA, value)
+#	define WRITE_M(value) write_m_table[EA_INDEX](object, value)
+#endif
 
-/* MARK: - Macros: Reusable Code */
-
-#define INSTRUCTION(name) static zuint8 name(M6502 *object)
+#endif
 
 
-#define COMPARE(register, ea_table)						  \
-	zuint8 v = READ_##ea_table;						  \
-	zuint8 result = register - v;						  \
-										  \
-	P = (zuint8)								  \
-		((P & ~NZCP)	       /* VP, XP, BP, DP, IP unchanged	       */ \
-		 | (result & NP)       /* NP = result.7			       */ \
-		 | ZP_ZERO(result)     /* ZP = 1 if result = 0, else ZP = 0    */ \
-		 | !!(register >= v)); /* CP = 1 if register >= v, else CP = 0 */ \
-										  \
-	return EA_CYCLES;
-
-
-#define BRANCH(flag_mask, condition_logic)		\
-	zuint8 cycles = 2;				\
-							\
-	if (condition_logic(P & flag_mask))		\
-		{					\
-		zuint16 pc = PC + 2;			\
-		zsint8 offset = (zsint8)READ_8(PC + 1); \
-		zuint16 t = (zuint16)(pc + offset);	\
-							\
-		if (t >> 8 == pc >> 8) cycles++;	\
-		else cycles += 2;			\
-		PC = t;					\
-		}					\
-							\
-	else PC += 2;					\
-							\
-	return cycles;
-
-
-#define BRANCH_IF_CLEAR(flag_mask) BRANCH(flag_mask, !)
-#define BRANCH_IF_SET(  flag_mask) BRANCH(flag_mask, Z_EMPTY)
-
-
-#define INC_DEC(operation)		\
-	zuint8 t = READ_G operation 1;	\
-					\
-	WRITE_G(t);			\
-	SET_P_NZ(t);			\
-	return EA_CYCLES;
+#if !defined(CPU_6502_WITH_SWITCH_DISPATCH) && !defined(CPU_6502_WITH_CYCLE_EXACT)
 
+#define INSTRUCTION(name) static zuint8 name(M6502 *object)
 
 /* MARK: - Instructions: Load/Store Operations
 .------------------------------------------.
@@ -481,7 +705,7 @@ INSTRUCTION(txs) {PC++; S = X;			return 2;}
 INSTRUCTION(pha) {PC++; PUSH_8(A);		return 3;}
 INSTRUCTION(php) {PC++; PUSH_8(P);		return 3;}
 INSTRUCTION(pla) {PC++; A = POP_8; SET_P_NZ(A); return 4;}
-INSTRUCTION(plp) {PC++; P = POP_8;		return 4;}
+INSTRUCTION(plp) {PC++; P = POP_8; PENDING = TRUE; return 4;}
 
 
 /* MARK: - Instructions: Logical
@@ -500,16 +724,7 @@ INSTRUCTION(eor_J) {A ^= READ_J; SET_P_NZ(A); return EA_CYCLES;}
 INSTRUCTION(ora_J) {A |= READ_J; SET_P_NZ(A); return EA_CYCLES;}
 
 
-INSTRUCTION(bit_Q)
-	{
-	zuint8 v = READ_Q;
-
-	P =	(P & ~(NP | VP | ZP))
-		| (v & (NP | VP)); /* TODO: Check if this is correct. */
-
-	if (!(v & A)) P |= ZP;
-	return EA_CYCLES;
-	}
+INSTRUCTION(bit_Q) {BIT(READ_Q) return EA_CYCLES;}
 
 
 /* MARK: - Instructions: Arithmetic
@@ -524,82 +739,11 @@ INSTRUCTION(bit_Q)
 |  sbc J       111jjj01  nv....zc  J	   |
 '-----------------------------------------*/
 
-INSTRUCTION(cmp_J) {COMPARE(A, J)}
-INSTRUCTION(cpx_Q) {COMPARE(X, Q)}
-INSTRUCTION(cpy_Q) {COMPARE(Y, Q)}
-
-
-INSTRUCTION(adc_J)
-	{
-	zuint8 v = READ_J, c = P & CP;
-
-	if (P & DP)
-		{
-		zuint l = (zuint)(A & 0x0F) + (v & 0x0F) + c;
-		zuint h = (zuint)(A & 0xF0) + (v & 0xF0);
-
-		P &= ~(VP | CP | NP | ZP);
-
-		if (!((l + h) & 0xFF))	       P |= ZP;
-		if (l > 0x09)		       {h += 0x10; l += 0x06;}
-		if (h & 0x80)		       P |= NP;
-		if (~(A ^ v) & (A ^ h) & 0x80) P |= VP;
-		if (h > 0x90)		       h += 0x60;
-		if (h >> 8)		       P |= CP;
-
-		A = (l & 0x0F) | (h & 0xF0);
-		}
-
-	else	{
-		zuint t = (zuint)A + v + c;
-
-		P &= ~(VP | CP);
-
-		if (~(A ^ v) & (A ^ t) & 0x80) P |= VP;
-		if (t >> 8)		       P |= CP;
-
-		A = (zuint8)t;
-		SET_P_NZ(A);
-		}
-
-	return EA_CYCLES;
-	}
-
-
-INSTRUCTION(sbc_J)
-	{
-	zuint8 v = READ_J, c = !(P & CP);
-	zuint  t = A - v - c;
-
-	if (P & DP)
-		{
-		zuint l = (zuint)(A & 0x0F) - (v & 0x0F) - c;
-		zuint h = (zuint)(A & 0xF0) - (v & 0xF0);
-
-		P &= ~(VP | CP | ZP | NP);
-
-		if (l & 0x10)		      {l -= 6; h--;}
-		if ((A ^ v) & (A ^ t) & 0x80) P |= VP;
-		if (!(t >> 8))		      P |= CP;
-		if (!(t << 8))		      P |= ZP;
-		if (t & 0x80)		      P |= NP;
-		if (h & 0x0100)		      h -= 0x60;
-
-		A = (l & 0x0F) | (h & 0xF0);
-		}
-
-	else	{
-		P &= ~(VP | CP);
-
-		if ((A ^ v) & (A ^ t) & 0x80) P |= VP;
-		if (!(t >> 8))		      P |= CP;
-
-		A = (zuint8)t;
-		SET_P_NZ(A);
-		}
-
-	return EA_CYCLES;
-	}
+INSTRUCTION(cmp_J) {COMPARE(A, READ_J) return EA_CYCLES;}
+INSTRUCTION(cpx_Q) {COMPARE(X, READ_Q) return EA_CYCLES;}
+INSTRUCTION(cpy_Q) {COMPARE(Y, READ_Q) return EA_CYCLES;}
+INSTRUCTION(adc_J) {ADC(READ_J)	       return EA_CYCLES;}
+INSTRUCTION(sbc_J) {SBC(READ_J)	       return EA_CYCLES;}
 
 
 /* MARK: - Instructions: Increments & Decrements
@@ -615,10 +759,10 @@ INSTRUCTION(sbc_J)
 |  dey	       <  88  >  n.....z.  2	   |
 '-----------------------------------------*/
 
-INSTRUCTION(inc_G) {INC_DEC(+)			     }
+INSTRUCTION(inc_G) {INC_DEC(+, READ_G, WRITE_G) return EA_CYCLES;}
 INSTRUCTION(inx)   {PC++; X++; SET_P_NZ(X); return 2;}
 INSTRUCTION(iny)   {PC++; Y++; SET_P_NZ(Y); return 2;}
-INSTRUCTION(dec_G) {INC_DEC(-)			     }
+INSTRUCTION(dec_G) {INC_DEC(-, READ_G, WRITE_G) return EA_CYCLES;}
 INSTRUCTION(dex)   {PC++; X--; SET_P_NZ(X); return 2;}
 INSTRUCTION(dey)   {PC++; Y--; SET_P_NZ(Y); return 2;}
 
@@ -635,44 +779,10 @@ INSTRUCTION(dey)   {PC++; Y--; SET_P_NZ(Y); return 2;}
 '-----------------------------------------*/
 
 
-INSTRUCTION(asl_G)
-	{
-	zuint8 v = READ_G, t = (zuint8)(v << 1);
-
-	WRITE_G(t);
-	P = (zuint8)((P & ~NZCP) | (t & NP) | ZP_ZERO(t) | (v >> 7));
-	return EA_CYCLES;
-	}
-
-
-INSTRUCTION(lsr_G)
-	{
-	zuint8 v = READ_G, t = v >> 1;
-
-	WRITE_G(t);
-	P = (zuint8)((P & ~NZCP) | ZP_ZERO(t) | (v & CP));
-	return EA_CYCLES;
-	}
-
-
-INSTRUCTION(rol_G)
-	{
-	zuint8 v = READ_G, t = (zuint8)((v << 1) | (P & CP));
-
-	WRITE_G(t);
-	P = (zuint8)((P & ~NZCP) | (t & NP) | ZP_ZERO(t) | (v >> 7));
-	return EA_CYCLES;
-	}
-
-
-INSTRUCTION(ror_G)
-	{
-	zuint8 v = READ_G, t = (zuint8)((v >> 1) | ((P & CP) << 7));
-
-	WRITE_G(t);
-	P = (zuint8)((P & ~NZCP) | (t & NP) | ZP_ZERO(t) | (v & CP));
-	return EA_CYCLES;
-	}
+INSTRUCTION(asl_G) {ASL(READ_G, WRITE_G) return EA_CYCLES;}
+INSTRUCTION(lsr_G) {LSR(READ_G, WRITE_G) return EA_CYCLES;}
+INSTRUCTION(rol_G) {ROL(READ_G, WRITE_G) return EA_CYCLES;}
+INSTRUCTION(ror_G) {ROR(READ_G, WRITE_G) return EA_CYCLES;}
 
 
 /* MARK: - Instructions: Jumps & Calls
@@ -687,7 +797,7 @@ INSTRUCTION(ror_G)
 '---------------------------------------------------------*/
 
 INSTRUCTION(jmp_WORD)  {PC = READ_16(PC + 1);		       return 3;}
-INSTRUCTION(jmp_vWORD) {PC = READ_16(READ_16(PC + 1));	       return 5;}
+INSTRUCTION(jmp_vWORD) {PC = READ_16(READ_16(PC + 1));	       return JMP_IND_CYCLES;}
 INSTRUCTION(jsr_WORD)  {PUSH_16(PC + 2); PC = READ_16(PC + 1); return 6;}
 INSTRUCTION(rts)       {PC = POP_16 + 1;		       return 6;}
 
@@ -707,14 +817,14 @@ INSTRUCTION(rts)       {PC = POP_16 + 1;		       return 6;}
 |  bvs OFFSET  <  70  ><OFFSET>  ........  2 / 3 / 4  |
 '----------------------------------------------------*/
 
-INSTRUCTION(bcc_OFFSET) {BRANCH_IF_CLEAR(CP);}
-INSTRUCTION(bcs_OFFSET) {BRANCH_IF_SET	(CP);}
-INSTRUCTION(beq_OFFSET) {BRANCH_IF_SET	(ZP);}
-INSTRUCTION(bmi_OFFSET) {BRANCH_IF_SET	(NP);}
-INSTRUCTION(bne_OFFSET) {BRANCH_IF_CLEAR(ZP);}
-INSTRUCTION(bpl_OFFSET) {BRANCH_IF_CLEAR(NP);}
-INSTRUCTION(bvc_OFFSET) {BRANCH_IF_CLEAR(VP);}
-INSTRUCTION(bvs_OFFSET) {BRANCH_IF_SET	(VP);}
+INSTRUCTION(bcc_OFFSET) {zuint8 cycles; BRANCH_IF_CLEAR(CP, cycles) return cycles;}
+INSTRUCTION(bcs_OFFSET) {zuint8 cycles; BRANCH_IF_SET	(CP, cycles) return cycles;}
+INSTRUCTION(beq_OFFSET) {zuint8 cycles; BRANCH_IF_SET	(ZP, cycles) return cycles;}
+INSTRUCTION(bmi_OFFSET) {zuint8 cycles; BRANCH_IF_SET	(NP, cycles) return cycles;}
+INSTRUCTION(bne_OFFSET) {zuint8 cycles; BRANCH_IF_CLEAR(ZP, cycles) return cycles;}
+INSTRUCTION(bpl_OFFSET) {zuint8 cycles; BRANCH_IF_CLEAR(NP, cycles) return cycles;}
+INSTRUCTION(bvc_OFFSET) {zuint8 cycles; BRANCH_IF_CLEAR(VP, cycles) return cycles;}
+INSTRUCTION(bvs_OFFSET) {zuint8 cycles; BRANCH_IF_SET	(VP, cycles) return cycles;}
 
 
 /* MARK: - Instructions: Status Flag Changes
@@ -733,7 +843,7 @@ INSTRUCTION(bvs_OFFSET) {BRANCH_IF_SET	(VP);}
 
 INSTRUCTION(clc) {PC++; P &= ~CP; return 2;}
 INSTRUCTION(cld) {PC++; P &= ~DP; return 2;}
-INSTRUCTION(cli) {PC++; P &= ~IP; return 2;}
+INSTRUCTION(cli) {PC++; P &= ~IP; PENDING = TRUE; return 2;}
 INSTRUCTION(clv) {PC++; P &= ~VP; return 2;}
 INSTRUCTION(sec) {PC++; P |=  CP; return 2;}
 INSTRUCTION(sed) {PC++; P |=  DP; return 2;}
@@ -751,22 +861,206 @@ INSTRUCTION(sei) {PC++; P |=  IP; return 2;}
 '-----------------------------------------*/
 
 INSTRUCTION(nop) {PC++;			  return 2;}
-INSTRUCTION(rti) {P = POP_8; PC = POP_16; return 6;}
+INSTRUCTION(rti) {P = POP_8; PC = POP_16; PENDING = TRUE; return 6;}
 
 
-INSTRUCTION(brk)
-	{
-	READ_8 (PC + 1); /* BRK padding byte, ignored but the access is emulated */
-	PUSH_16(PC + 2);
-	PUSH_8(P | BP);
-	P |=  BP | IP;
-	PC = READ_POINTER(BRK);
-	return 7;
-	}
+INSTRUCTION(brk) {BRK return 7;}
+
+
+#ifdef CPU_6502_VARIANT_65C02
+
+/* MARK: - Instructions: 65C02
+.------------------------------------------.
+|		Opcode	  Flags		  |
+|  Assembly    76543210  nvxbdizc  Cycles  |
+|  --------------------------------------  |
+|  ora (BYTE)  <  12  >  n.....z.  5	   |
+|  and (BYTE)  <  32  >  n.....z.  5	   |
+|  eor (BYTE)  <  52  >  n.....z.  5	   |
+|  adc (BYTE)  <  72  >  nv....zc  5	   |
+|  sta (BYTE)  <  92  >  ........  5	   |
+|  lda (BYTE)  <  B2  >  n.....z.  5	   |
+|  cmp (BYTE)  <  D2  >  n.....zc  5	   |
+|  sbc (BYTE)  <  F2  >  nv....zc  5	   |
+|  bit #BYTE   <  89  >  ......z.  2	   |
+|  stz Q       011qqq00  ........  Q	   |
+|  stz WORD    <  9C  >  ........  4	   |
+|  stz WORD,X  <  9E  >  ........  5	   |
+|  tsb G       000ggg00  ......z.  G	   |
+|  trb BYTE    <  14  >  ......z.  5	   |
+|  trb WORD    <  1C  >  ......z.  6	   |
+|  inc A       <  1A  >  n.....z.  2	   |
+|  dec A       <  3A  >  n.....z.  2	   |
+|  phx	       <  DA  >  ........  3	   |
+|  phy	       <  5A  >  ........  3	   |
+|  plx	       <  FA  >  n.....z.  4	   |
+|  ply	       <  7A  >  n.....z.  4	   |
+|  bra OFFSET  <  80  >  ........  3 / 4   |
+|  jmp (WORD,X)<  7C  >  ........  6	   |
+|  nop H/Q     xxxxxxxx  ........  H/Q	   |
+|  nop WORD    <DC, FC>  ........  4	   |
+|  nop WORD    <  5C  >  ........  8	   |
+|  nop	       xxxxxx11  ........  1	   |
+'-----------------------------------------*/
+
+INSTRUCTION(ora_vBYTE) {A |= read_indirect_zp(object); SET_P_NZ(A); return EA_CYCLES;}
+INSTRUCTION(and_vBYTE) {A &= read_indirect_zp(object); SET_P_NZ(A); return EA_CYCLES;}
+INSTRUCTION(eor_vBYTE) {A ^= read_indirect_zp(object); SET_P_NZ(A); return EA_CYCLES;}
+INSTRUCTION(adc_vBYTE) {ADC(read_indirect_zp(object))		    return EA_CYCLES;}
+INSTRUCTION(sta_vBYTE) {write_indirect_zp(object, A);		    return EA_CYCLES;}
+INSTRUCTION(lda_vBYTE) {A = read_indirect_zp(object); SET_P_NZ(A);  return EA_CYCLES;}
+INSTRUCTION(cmp_vBYTE) {COMPARE(A, read_indirect_zp(object))	    return EA_CYCLES;}
+INSTRUCTION(sbc_vBYTE) {SBC(read_indirect_zp(object))		    return EA_CYCLES;}
+
+
+INSTRUCTION(bit_BYTE)	{BIT_IMMEDIATE(READ_BYTE_OPERAND)	   return 2;}
+INSTRUCTION(stz_Q)	{WRITE_Q(0);				   return EA_CYCLES;}
+INSTRUCTION(stz_WORD)	{WRITE_8(ABSOLUTE_ADDRESS,   0);	   return 4;}
+INSTRUCTION(stz_WORD_X) {WRITE_8(ABSOLUTE_X_ADDRESS, 0);	   return 5;}
+INSTRUCTION(tsb_G)	{TSB(READ_G, WRITE_G)			   return EA_CYCLES;}
+INSTRUCTION(trb_BYTE)	{TRB(read_g_zero_page(object), WRITE_G)	   return 5;}
+INSTRUCTION(trb_WORD)	{TRB(read_g_absolute (object), WRITE_G)	   return 6;}
+INSTRUCTION(inc_A)	{PC++; A++; SET_P_NZ(A);		   return 2;}
+INSTRUCTION(dec_A)	{PC++; A--; SET_P_NZ(A);		   return 2;}
+INSTRUCTION(phx)	{PC++; PUSH_8(X);			   return 3;}
+INSTRUCTION(phy)	{PC++; PUSH_8(Y);			   return 3;}
+INSTRUCTION(plx)	{PC++; X = POP_8; SET_P_NZ(X);		   return 4;}
+INSTRUCTION(ply)	{PC++; Y = POP_8; SET_P_NZ(Y);		   return 4;}
+INSTRUCTION(bra_OFFSET) {zuint8 cycles; BRANCH(TRUE, cycles)	   return cycles;}
+INSTRUCTION(jmp_vWORD_X) {PC = READ_16(READ_16(PC + 1) + X);	   return 6;}
+
+
+/*------------------------------------------------------------------.
+| The remaining opcodes are nops: those in the xxxxxx11 columns are |
+| one byte long and take one cycle, the others read their operand.  |
+'------------------------------------------------------------------*/
+
+INSTRUCTION(nop_H)	{READ_H;			 return EA_CYCLES;}
+INSTRUCTION(nop_Q)	{READ_Q;			 return EA_CYCLES;}
+INSTRUCTION(nop_WORD)	{READ_8(ABSOLUTE_ADDRESS);	 return 4;}
+INSTRUCTION(nop_5C)	{PC += 3;			 return 8;}
+INSTRUCTION(nop_1)	{PC++;				 return 1;}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+
+/* MARK: - Instructions: Undocumented
+.------------------------------------------.
+|	       Opcode	 Flags		   |
+|  Assembly    76543210  nvxbdizc  Cycles  |
+|  --------------------------------------  |
+|  slo L       000lll11  n.....zc  L	   |
+|  rla L       001lll11  n.....zc  L	   |
+|  sre L       010lll11  n.....zc  L	   |
+|  rra L       011lll11  nv....zc  L	   |
+|  sax M       100mmm11  ........  M	   |
+|  lax M       101mmm11  n.....z.  M	   |
+|  dcp L       110lll11  n.....zc  L	   |
+|  isc L       111lll11  nv....zc  L	   |
+|  anc #BYTE   <0B, 2B>  n.....zc  2	   |
+|  alr #BYTE   <  4B  >  n.....zc  2	   |
+|  arr #BYTE   <  6B  >  nv....zc  2	   |
+|  ane #BYTE   <  8B  >  n.....z.  2	   |
+|  lxa #BYTE   <  AB  >  n.....z.  2	   |
+|  sbx #BYTE   <  CB  >  n.....zc  2	   |
+|  sbc #BYTE   <  EB  >  nv....zc  2	   |
+|  las WORD,Y  <  BB  >  n.....z.  4+1     |
+|  sha (BYTE),Y<  93  >  ........  6	   |
+|  sha WORD,Y  <  9F  >  ........  5	   |
+|  shx WORD,Y  <  9E  >  ........  5	   |
+|  shy WORD,X  <  9C  >  ........  5	   |
+|  tas WORD,Y  <  9B  >  ........  5	   |
+|  nop J/H/Q   xxxxxxxx  ........  J/H/Q   |
+|  jam	       xxx10010  ........  -	   |
+'-----------------------------------------*/
+
+INSTRUCTION(slo_L) {SLO(READ_L, WRITE_L) return EA_CYCLES;}
+INSTRUCTION(rla_L) {RLA(READ_L, WRITE_L) return EA_CYCLES;}
+INSTRUCTION(sre_L) {SRE(READ_L, WRITE_L) return EA_CYCLES;}
+INSTRUCTION(rra_L) {RRA(READ_L, WRITE_L) return EA_CYCLES;}
+INSTRUCTION(dcp_L) {DCP(READ_L, WRITE_L) return EA_CYCLES;}
+INSTRUCTION(isc_L) {ISC(READ_L, WRITE_L) return EA_CYCLES;}
+INSTRUCTION(sax_M) {WRITE_M(A & X);	 return EA_CYCLES;}
+INSTRUCTION(lax_M) {LAX(READ_M)		 return EA_CYCLES;}
+INSTRUCTION(lxa_M) {LXA(READ_M)		 return EA_CYCLES;}
+INSTRUCTION(las_M) {LAS(READ_M)		 return EA_CYCLES;}
+INSTRUCTION(anc_J) {ANC(READ_J)		 return EA_CYCLES;}
+INSTRUCTION(alr_J) {ALR(READ_J)		 return EA_CYCLES;}
+INSTRUCTION(arr_J) {ARR(READ_J)		 return EA_CYCLES;}
+INSTRUCTION(ane_J) {ANE(READ_J)		 return EA_CYCLES;}
+INSTRUCTION(sbx_J) {SBX(READ_J)		 return EA_CYCLES;}
+INSTRUCTION(nop_J) {READ_J;		 return EA_CYCLES;}
+INSTRUCTION(nop_H) {READ_H;		 return EA_CYCLES;}
+INSTRUCTION(nop_Q) {READ_Q;		 return EA_CYCLES;}
+
+
+INSTRUCTION(sha_vBYTE_Y) {UNSTABLE_STORE(READ_16(READ_BYTE_OPERAND), Y, A & X, WRITE_8) return 6;}
+INSTRUCTION(sha_WORD_Y)	 {UNSTABLE_STORE(READ_WORD_OPERAND,	    Y, A & X, WRITE_8) return 5;}
+INSTRUCTION(shx_WORD_Y)	 {UNSTABLE_STORE(READ_WORD_OPERAND,	    Y, X,     WRITE_8) return 5;}
+INSTRUCTION(shy_WORD_X)	 {UNSTABLE_STORE(READ_WORD_OPERAND,	    X, Y,     WRITE_8) return 5;}
+INSTRUCTION(tas_WORD_Y)	 {S = A & X; UNSTABLE_STORE(READ_WORD_OPERAND, Y, S, WRITE_8) return 5;}
+
+
+/*-------------------------------------------------------------------.
+| jam halts the CPU: the opcode is executed again and again, and the |
+| interrupts are ignored until the next reset.			     |
+'-------------------------------------------------------------------*/
+
+INSTRUCTION(jam) {JAMMED = TRUE; return 2;}
+
+#endif
 
 
 /* MARK: - Instruction Function Table */
 
+#ifdef CPU_6502_VARIANT_65C02
+
+static Instruction const instruction_table[256] = {
+/*	0	    1	   2	      3	     4	       5      6	     7	    8	 9	   A	  B	 C	      D	     E		 F */
+/* 0 */ brk,	    ora_J, nop_H,     nop_1, tsb_G,    ora_J, asl_G, nop_1, php, ora_J,	   asl_G, nop_1, tsb_G,	      ora_J, asl_G,	 nop_1,
+/* 1 */ bpl_OFFSET, ora_J, ora_vBYTE, nop_1, trb_BYTE, ora_J, asl_G, nop_1, clc, ora_J,	   inc_A, nop_1, trb_WORD,    ora_J, asl_G,	 nop_1,
+/* 2 */ jsr_WORD,   and_J, nop_H,     nop_1, bit_Q,    and_J, rol_G, nop_1, plp, and_J,	   rol_G, nop_1, bit_Q,	      and_J, rol_G,	 nop_1,
+/* 3 */ bmi_OFFSET, and_J, and_vBYTE, nop_1, bit_Q,    and_J, rol_G, nop_1, sec, and_J,	   dec_A, nop_1, bit_Q,	      and_J, rol_G,	 nop_1,
+/* 4 */ rti,	    eor_J, nop_H,     nop_1, nop_Q,    eor_J, lsr_G, nop_1, pha, eor_J,	   lsr_G, nop_1, jmp_WORD,    eor_J, lsr_G,	 nop_1,
+/* 5 */ bvc_OFFSET, eor_J, eor_vBYTE, nop_1, nop_Q,    eor_J, lsr_G, nop_1, cli, eor_J,	   phy,	  nop_1, nop_5C,      eor_J, lsr_G,	 nop_1,
+/* 6 */ rts,	    adc_J, nop_H,     nop_1, stz_Q,    adc_J, ror_G, nop_1, pla, adc_J,	   ror_G, nop_1, jmp_vWORD,   adc_J, ror_G,	 nop_1,
+/* 7 */ bvs_OFFSET, adc_J, adc_vBYTE, nop_1, stz_Q,    adc_J, ror_G, nop_1, sei, adc_J,	   ply,	  nop_1, jmp_vWORD_X, adc_J, ror_G,	 nop_1,
+/* 8 */ bra_OFFSET, sta_K, nop_H,     nop_1, sty_Q,    sta_K, stx_H, nop_1, dey, bit_BYTE, txa,	  nop_1, sty_Q,	      sta_K, stx_H,	 nop_1,
+/* 9 */ bcc_OFFSET, sta_K, sta_vBYTE, nop_1, sty_Q,    sta_K, stx_H, nop_1, tya, sta_K,	   txs,	  nop_1, stz_WORD,    sta_K, stz_WORD_X, nop_1,
+/* A */ ldy_Q,	    lda_J, ldx_H,     nop_1, ldy_Q,    lda_J, ldx_H, nop_1, tay, lda_J,	   tax,	  nop_1, ldy_Q,	      lda_J, ldx_H,	 nop_1,
+/* B */ bcs_OFFSET, lda_J, lda_vBYTE, nop_1, ldy_Q,    lda_J, ldx_H, nop_1, clv, lda_J,	   tsx,	  nop_1, ldy_Q,	      lda_J, ldx_H,	 nop_1,
+/* C */ cpy_Q,	    cmp_J, nop_H,     nop_1, cpy_Q,    cmp_J, dec_G, nop_1, iny, cmp_J,	   dex,	  nop_1, cpy_Q,	      cmp_J, dec_G,	 nop_1,
+/* D */ bne_OFFSET, cmp_J, cmp_vBYTE, nop_1, nop_Q,    cmp_J, dec_G, nop_1, cld, cmp_J,	   phx,	  nop_1, nop_WORD,    cmp_J, dec_G,	 nop_1,
+/* E */ cpx_Q,	    sbc_J, nop_H,     nop_1, cpx_Q,    sbc_J, inc_G, nop_1, inx, sbc_J,	   nop,	  nop_1, cpx_Q,	      sbc_J, inc_G,	 nop_1,
+/* F */ beq_OFFSET, sbc_J, sbc_vBYTE, nop_1, nop_Q,    sbc_J, inc_G, nop_1, sed, sbc_J,	   plx,	  nop_1, nop_WORD,    sbc_J, inc_G,	 nop_1
+};
+
+#elif defined(CPU_6502_WITH_UNDOCUMENTED_OPCODES)
+
+static Instruction const instruction_table[256] = {
+/*	0	    1	   2	  3	       4      5	     6	    7	   8	9      A      B		  C	      D	     E		F */
+/* 0 */ brk,	    ora_J, jam,	  slo_L,       nop_Q, ora_J, asl_G, slo_L, php, ora_J, asl_G, anc_J,	  nop_Q,      ora_J, asl_G,	 slo_L,
+/* 1 */ bpl_OFFSET, ora_J, jam,	  slo_L,       nop_Q, ora_J, asl_G, slo_L, clc, ora_J, nop,   slo_L,	  nop_Q,      ora_J, asl_G,	 slo_L,
+/* 2 */ jsr_WORD,   and_J, jam,	  rla_L,       bit_Q, and_J, rol_G, rla_L, plp, and_J, rol_G, anc_J,	  bit_Q,      and_J, rol_G,	 rla_L,
+/* 3 */ bmi_OFFSET, and_J, jam,	  rla_L,       nop_Q, and_J, rol_G, rla_L, sec, and_J, nop,   rla_L,	  nop_Q,      and_J, rol_G,	 rla_L,
+/* 4 */ rti,	    eor_J, jam,	  sre_L,       nop_Q, eor_J, lsr_G, sre_L, pha, eor_J, lsr_G, alr_J,	  jmp_WORD,   eor_J, lsr_G,	 sre_L,
+/* 5 */ bvc_OFFSET, eor_J, jam,	  sre_L,       nop_Q, eor_J, lsr_G, sre_L, cli, eor_J, nop,   sre_L,	  nop_Q,      eor_J, lsr_G,	 sre_L,
+/* 6 */ rts,	    adc_J, jam,	  rra_L,       nop_Q, adc_J, ror_G, rra_L, pla, adc_J, ror_G, arr_J,	  jmp_vWORD,  adc_J, ror_G,	 rra_L,
+/* 7 */ bvs_OFFSET, adc_J, jam,	  rra_L,       nop_Q, adc_J, ror_G, rra_L, sei, adc_J, nop,   rra_L,	  nop_Q,      adc_J, ror_G,	 rra_L,
+/* 8 */ nop_Q,	    sta_K, nop_H, sax_M,       sty_Q, sta_K, stx_H, sax_M, dey, nop_J, txa,   ane_J,	  sty_Q,      sta_K, stx_H,	 sax_M,
+/* 9 */ bcc_OFFSET, sta_K, jam,	  sha_vBYTE_Y, sty_Q, sta_K, stx_H, sax_M, tya, sta_K, txs,   tas_WORD_Y, shy_WORD_X, sta_K, shx_WORD_Y, sha_WORD_Y,
+/* A */ ldy_Q,	    lda_J, ldx_H, lax_M,       ldy_Q, lda_J, ldx_H, lax_M, tay, lda_J, tax,   lxa_M,	  ldy_Q,      lda_J, ldx_H,	 lax_M,
+/* B */ bcs_OFFSET, lda_J, jam,	  lax_M,       ldy_Q, lda_J, ldx_H, lax_M, clv, lda_J, tsx,   las_M,	  ldy_Q,      lda_J, ldx_H,	 lax_M,
+/* C */ cpy_Q,	    cmp_J, nop_H, dcp_L,       cpy_Q, cmp_J, dec_G, dcp_L, iny, cmp_J, dex,   sbx_J,	  cpy_Q,      cmp_J, dec_G,	 dcp_L,
+/* D */ bne_OFFSET, cmp_J, jam,	  dcp_L,       nop_Q, cmp_J, dec_G, dcp_L, cld, cmp_J, nop,   dcp_L,	  nop_Q,      cmp_J, dec_G,	 dcp_L,
+/* E */ cpx_Q,	    sbc_J, nop_H, isc_L,       cpx_Q, sbc_J, inc_G, isc_L, inx, sbc_J, nop,   sbc_J,	  cpx_Q,      sbc_J, inc_G,	 isc_L,
+/* F */ beq_OFFSET, sbc_J, jam,	  isc_L,       nop_Q, sbc_J, inc_G, isc_L, sed, sbc_J, nop,   isc_L,	  nop_Q,      sbc_J, inc_G,	 isc_L
+};
+
+#else
+
 #define illegal nop
 
 static Instruction const instruction_table[256] = {
@@ -789,88 +1083,2172 @@ static Instruction const instruction_table[256] = {
 /* F */	beq_OFFSET, sbc_J, illegal, illegal, illegal, sbc_J, inc_G, illegal, sed, sbc_J,   illegal, illegal, illegal,	sbc_J, inc_G,	illegal
 };
 
+#endif
 
-/* MARK: - Main Functions */
+#elif defined(CPU_6502_WITH_SWITCH_DISPATCH)
 
-CPU_6502_API void m6502_power(M6502 *object, zboolean state)
-	{
-	if (state)
+/* MARK: - Switch Dispatch
+.-----------------------------------------------------------------------------.
+| When built with CPU_6502_WITH_SWITCH_DISPATCH, m6502_run decodes opcodes    |
+| with a switch statement instead of the instruction function table. Every    |
+| case has its addressing mode resolved at compile time, so neither the       |
+| J/G/H/K/Q tables nor the OPCODE, EA and EA_CYCLES temporaries are involved. |
+| The resulting bus accesses and cycle counts are identical. The cases are    |
+| defined in `6502-semantics.h`, which the C++ front end also includes.	      |
+'----------------------------------------------------------------------------*/
+
+#define DONE(cycles) instruction_cycles = cycles; break
+#define EXTRA_CYCLE  CYCLES++;
+
+#ifdef CPU_6502_WITH_DECODE_CACHE
+
+	static M6502DecodedInstruction const *decode(M6502 *object, zuint16 pc)
 		{
-		PC = Z_6502_VALUE_AFTER_POWER_ON_PC;
-		S  = Z_6502_VALUE_AFTER_POWER_ON_S;
-		P  = Z_6502_VALUE_AFTER_POWER_ON_P;
-		A  = Z_6502_VALUE_AFTER_POWER_ON_A;
-		X  = Z_6502_VALUE_AFTER_POWER_ON_X;
-		Y  = Z_6502_VALUE_AFTER_POWER_ON_Y;
-		IRQ = NMI = FALSE;
+		zuint16 pc1 = (zuint16)(pc + 1);
+		zuint16 pc2 = (zuint16)(pc + 2);
+		zuint8 const *page0 = object->read_pages[pc  >> 8];
+		zuint8 const *page1 = object->read_pages[pc1 >> 8];
+		zuint8 const *page2 = object->read_pages[pc2 >> 8];
+		M6502DecodeCache *cache = object->decode_cache;
+		M6502DecodedInstruction *instruction;
+
+		/*----------------------------------------------------------------.
+		| Only code in pages backed by host memory can be cached, because |
+		| reads performed through the callbacks may have side effects.	  |
+		'----------------------------------------------------------------*/
+		if (page0 == NULL || page1 == NULL || page2 == NULL) return NULL;
+
+		instruction	     = &cache->instructions[pc];
+		instruction->opcode  = page0[pc & 0xFF];
+		instruction->operand = (zuint16)(page1[pc1 & 0xFF] | page2[pc2 & 0xFF] << 8);
+		instruction->valid   = TRUE;
+
+		cache->code_pages[pc  >> 8] =
+		cache->code_pages[pc1 >> 8] =
+		cache->code_pages[pc2 >> 8] = TRUE;
+
+		return instruction;
 		}
 
-	else PC = S = P = A = X = Y = IRQ = NMI = 0;
-	}
 
+	static Z_INLINE M6502DecodedInstruction const *fetch(M6502 *object, zuint16 pc)
+		{
+		M6502DecodeCache *cache = object->decode_cache;
 
-CPU_6502_API void m6502_reset(M6502 *object)
-	{
-	PC = READ_POINTER(RESET);
-	S = Z_6502_VALUE_AFTER_POWER_ON_S;
-	P = Z_6502_VALUE_AFTER_POWER_ON_P;
-	IRQ = NMI = FALSE;
-	}
+		if (cache == NULL) return NULL;
+		if (cache->instructions[pc].valid) return &cache->instructions[pc];
+		return decode(object, pc);
+		}
 
 
-CPU_6502_API zusize m6502_run(M6502 *object, zusize cycles)
+#	define CACHED_INSTRUCTION fetch(object, PC)
+
+#else
+#	define CACHED_INSTRUCTION NULL
+#endif
+
+#ifdef CPU_6502_WITH_FETCH
+
+	/*----------------------------------------------------------------.
+	| The fetch callback is not used while the record/replay log is	  |
+	| active, because the reads it replaces could not be logged.	  |
+	'----------------------------------------------------------------*/
+
+#	ifdef CPU_6502_WITH_RECORD_REPLAY
+#		define FETCH_ALLOWED (object->fetch != NULL && !object->log_mode)
+#	else
+#		define FETCH_ALLOWED (object->fetch != NULL)
+#	endif
+
+#	define FETCH_CALLBACK(address) object->fetch(object->context, address)
+
+#	define FETCHED_INSTRUCTION						\
+		(FETCH_ALLOWED							\
+			? (fetched_bytes   = FETCH_CALLBACK(PC),		\
+			   fetched.opcode  = (zuint8)fetched_bytes,		\
+			   fetched.operand = (zuint16)(fetched_bytes >> 8),	\
+			   fetched.valid   = TRUE,				\
+			   &fetched)						\
+			: NULL)
+
+#else
+#	define FETCHED_INSTRUCTION NULL
+#endif
+
+#if defined(CPU_6502_WITH_DECODE_CACHE) || defined(CPU_6502_WITH_FETCH)
+#	undef FETCH_OPCODE
+
+#	define FETCH_OPCODE					\
+		((instruction = CACHED_INSTRUCTION)  != NULL || \
+		 (instruction = FETCHED_INSTRUCTION) != NULL	\
+			? instruction->opcode : READ_8(PC))
+#endif
+
+#else
+
+/* MARK: - Cycle-Exact Dispatch
+.-----------------------------------------------------------------------------.
+| When built with CPU_6502_WITH_CYCLE_EXACT, m6502_run performs one bus	      |
+| access per cycle, including the dummy reads and writes of the NMOS 6502,    |
+| and advances `cycles` after each access. The interrupt lines are sampled    |
+| before the last cycle of each instruction, as the real CPU does, and the    |
+| result is kept in `interrupt_poll` until the next instruction boundary.     |
+| The addresses and results computed are the same as in the other modes.      |
+'----------------------------------------------------------------------------*/
+
+#define POLL_IRQ 1
+#define POLL_NMI 2
+
+#define POLL_INTERRUPTS \
+	object->interrupt_poll = (zuint8)((NMI ? POLL_NMI : 0) | (IRQ && !(P & IP) ? POLL_IRQ : 0))
+
+
+static zuint8 cycle_read(M6502 *object, zuint16 address)
+	{
+	zuint8 value;
+
+	POLL_INTERRUPTS;
+	value = READ_8(address);
+	CYCLES++;
+	return value;
+	}
+
+
+static void cycle_write(M6502 *object, zuint16 address, zuint8 value)
+	{
+	POLL_INTERRUPTS;
+	WRITE_8(address, value);
+	CYCLES++;
+	}
+
+
+#define CYCLE_READ(address)	  cycle_read (object, (zuint16)(address))
+#define CYCLE_WRITE(address, value) cycle_write(object, (zuint16)(address), (zuint8)(value))
+#define FETCH			  CYCLE_READ(PC++)
+#define IMPLIED			  CYCLE_READ(PC)
+#define DUMMY_STACK_READ	  CYCLE_READ(Z_6502_ADDRESS_STACK | S)
+#define PUSH(value)		  CYCLE_WRITE(Z_6502_ADDRESS_STACK | S--, value)
+#define PULL			  CYCLE_READ (Z_6502_ADDRESS_STACK | ++S)
+#define READ_MODIFY \
+	(value = CYCLE_READ(address), CYCLE_WRITE(address, value), value)
+
+#define WRITE_MODIFIED(value) CYCLE_WRITE(address, value)
+#define IMPLIED_ACCUMULATOR   (IMPLIED, A)
+
+#define ZERO_PAGE address = FETCH;
+
+#define ZERO_PAGE_INDEXED(index) \
+	address = FETCH;		 \
+	CYCLE_READ(address);		 \
+	address = (zuint8)(address + index);
+
+#define ABSOLUTE \
+	address = FETCH; \
+	address |= (zuint16)(FETCH << 8);
+
+/*-----------------------------------------------------------------.
+| The high byte of indexed addresses is fixed in an extra cycle,   |
+| during which the CPU reads from the unfixed address. Reads do it |
+| only if a page boundary is crossed; writes do it always.	   |
+'-----------------------------------------------------------------*/
+
+#define FIX_INDEXED(index, always)					\
+	if (always || (address & 0xFF) + index > 255)			\
+		CYCLE_READ((address & 0xFF00) | ((address + index) & 0xFF));	\
+									\
+	address = (zuint16)(address + index);
+
+#define ABSOLUTE_INDEXED(index, always) \
+	ABSOLUTE			\
+	FIX_INDEXED(index, always)
+
+#define INDIRECT_X					 \
+	pointer = FETCH;				 \
+	CYCLE_READ(pointer);				 \
+	pointer = (zuint8)(pointer + X);		 \
+	address = CYCLE_READ(pointer);			 \
+	address |= (zuint16)(CYCLE_READ(pointer + 1) << 8);
+
+#define INDIRECT			\
+	pointer = FETCH;		\
+	address = CYCLE_READ(pointer);	\
+	address |= (zuint16)(CYCLE_READ(pointer + 1) << 8);
+
+#define INDIRECT_Y(always)	\
+	INDIRECT		\
+	FIX_INDEXED(Y, always)
+
+
+#define CYCLE_CASES_J(opcode, OPERATION)							\
+	case opcode | 0x01: INDIRECT_X		     OPERATION(CYCLE_READ(address)) break;	\
+	case opcode | 0x05: ZERO_PAGE		     OPERATION(CYCLE_READ(address)) break;	\
+	case opcode | 0x09:			     OPERATION(FETCH)		    break;	\
+	case opcode | 0x0D: ABSOLUTE		     OPERATION(CYCLE_READ(address)) break;	\
+	case opcode | 0x11: INDIRECT_Y(FALSE)	     OPERATION(CYCLE_READ(address)) break;	\
+	case opcode | 0x15: ZERO_PAGE_INDEXED(X)     OPERATION(CYCLE_READ(address)) break;	\
+	case opcode | 0x19: ABSOLUTE_INDEXED(Y, FALSE) OPERATION(CYCLE_READ(address)) break;	\
+	case opcode | 0x1D: ABSOLUTE_INDEXED(X, FALSE) OPERATION(CYCLE_READ(address)) break;
+
+
+#define CYCLE_CASES_G_MEMORY(opcode, OPERATION)						\
+	case opcode | 0x06: ZERO_PAGE		    OPERATION(READ_MODIFY, WRITE_MODIFIED) break;	\
+	case opcode | 0x0E: ABSOLUTE		    OPERATION(READ_MODIFY, WRITE_MODIFIED) break;	\
+	case opcode | 0x16: ZERO_PAGE_INDEXED(X)    OPERATION(READ_MODIFY, WRITE_MODIFIED) break;	\
+	case opcode | 0x1E: ABSOLUTE_INDEXED(X, TRUE) OPERATION(READ_MODIFY, WRITE_MODIFIED) break;
+
+
+#define CYCLE_CASES_G(opcode, OPERATION)						\
+	case opcode | 0x0A: OPERATION(IMPLIED_ACCUMULATOR, WRITE_ACCUMULATOR) break;	\
+	CYCLE_CASES_G_MEMORY(opcode, OPERATION)
+
+
+#ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+
+#	define CYCLE_CASES_L(opcode, OPERATION)									\
+		case opcode | 0x03: INDIRECT_X		      OPERATION(READ_MODIFY, WRITE_MODIFIED) break;	\
+		case opcode | 0x07: ZERO_PAGE		      OPERATION(READ_MODIFY, WRITE_MODIFIED) break;	\
+		case opcode | 0x0F: ABSOLUTE		      OPERATION(READ_MODIFY, WRITE_MODIFIED) break;	\
+		case opcode | 0x13: INDIRECT_Y(TRUE)	      OPERATION(READ_MODIFY, WRITE_MODIFIED) break;	\
+		case opcode | 0x17: ZERO_PAGE_INDEXED(X)      OPERATION(READ_MODIFY, WRITE_MODIFIED) break;	\
+		case opcode | 0x1B: ABSOLUTE_INDEXED(Y, TRUE) OPERATION(READ_MODIFY, WRITE_MODIFIED) break;	\
+		case opcode | 0x1F: ABSOLUTE_INDEXED(X, TRUE) OPERATION(READ_MODIFY, WRITE_MODIFIED) break;
+
+
+#	define CYCLE_UNSTABLE_STORE(index, register_value)			\
+		CYCLE_READ((address & 0xFF00) | ((address + index) & 0xFF));	\
+		UNSTABLE_STORE(address, index, register_value, CYCLE_WRITE)
+
+#endif
+
+
+#define CYCLE_BRANCH(condition)							\
+	value = FETCH;								\
+										\
+	if (condition)								\
+		{								\
+		address = (zuint16)(PC + (zsint8)value);			\
+										\
+		/* A taken branch does not sample the interrupt lines	*/	\
+		/* again unless it crosses a page boundary.		*/	\
+		READ_8(PC);							\
+		CYCLES++;							\
+										\
+		if ((address ^ PC) & 0xFF00)					\
+			CYCLE_READ((PC & 0xFF00) | (address & 0xFF));		\
+										\
+		PC = address;							\
+		}
+
+
+static void cycle_exact_interrupt(M6502 *object, zuint16 vector)
+	{
+	zuint8 value;
+
+	CYCLE_READ(PC);
+	CYCLE_READ(PC);
+	PUSH(PC >> 8);
+	PUSH(PC);
+	P &= ~BP;
+	PUSH(P);
+	P |= IP;
+	value = CYCLE_READ(vector);
+	PC = (zuint16)(value | CYCLE_READ(vector + 1) << 8);
+
+	/* The first instruction of the handler is always executed. */
+	object->interrupt_poll = 0;
+	}
+
+
+static void cycle_exact_step(M6502 *object)
+	{
+	zuint16 address;
+	zuint8	pointer, value;
+
+	if (object->interrupt_poll & POLL_NMI)
+		{
+		NMI = FALSE;
+		cycle_exact_interrupt(object, Z_6502_ADDRESS_NMI_POINTER);
+		return;
+		}
+
+	if (object->interrupt_poll & POLL_IRQ)
+		{
+		cycle_exact_interrupt(object, Z_6502_ADDRESS_IRQ_POINTER);
+		return;
+		}
+
+	switch (FETCH)
+		{
+		CYCLE_CASES_J(0x00, ORA) CYCLE_CASES_J(0x20, AND) CYCLE_CASES_J(0x40, EOR)
+		CYCLE_CASES_J(0x60, ADC) CYCLE_CASES_J(0xA0, LDA) CYCLE_CASES_J(0xC0, CMP)
+		CYCLE_CASES_J(0xE0, SBC)
+
+		CYCLE_CASES_G(0x00, ASL) CYCLE_CASES_G(0x20, ROL) CYCLE_CASES_G(0x40, LSR)
+		CYCLE_CASES_G(0x60, ROR) CYCLE_CASES_G_MEMORY(0xC0, DEC) CYCLE_CASES_G_MEMORY(0xE0, INC)
+
+		/* sta K */
+		case 0x81: INDIRECT_X		      CYCLE_WRITE(address, A); break;
+		case 0x85: ZERO_PAGE		      CYCLE_WRITE(address, A); break;
+		case 0x8D: ABSOLUTE		      CYCLE_WRITE(address, A); break;
+		case 0x91: INDIRECT_Y(TRUE)	      CYCLE_WRITE(address, A); break;
+		case 0x95: ZERO_PAGE_INDEXED(X)	      CYCLE_WRITE(address, A); break;
+		case 0x99: ABSOLUTE_INDEXED(Y, TRUE)  CYCLE_WRITE(address, A); break;
+		case 0x9D: ABSOLUTE_INDEXED(X, TRUE)  CYCLE_WRITE(address, A); break;
+
+		/* ldx H, stx H */
+		case 0xA2:			      LDX(FETCH)	       break;
+		case 0xA6: ZERO_PAGE		      LDX(CYCLE_READ(address)) break;
+		case 0xAE: ABSOLUTE		      LDX(CYCLE_READ(address)) break;
+		case 0xB6: ZERO_PAGE_INDEXED(Y)	      LDX(CYCLE_READ(address)) break;
+		case 0xBE: ABSOLUTE_INDEXED(Y, FALSE) LDX(CYCLE_READ(address)) break;
+		case 0x86: ZERO_PAGE		      CYCLE_WRITE(address, X); break;
+		case 0x8E: ABSOLUTE		      CYCLE_WRITE(address, X); break;
+		case 0x96: ZERO_PAGE_INDEXED(Y)	      CYCLE_WRITE(address, X); break;
+
+		/* ldy Q, sty Q, bit Q, cpy Q, cpx Q */
+		case 0xA0:			      LDY(FETCH)	       break;
+		case 0xA4: ZERO_PAGE		      LDY(CYCLE_READ(address)) break;
+		case 0xAC: ABSOLUTE		      LDY(CYCLE_READ(address)) break;
+		case 0xB4: ZERO_PAGE_INDEXED(X)	      LDY(CYCLE_READ(address)) break;
+		case 0xBC: ABSOLUTE_INDEXED(X, FALSE) LDY(CYCLE_READ(address)) break;
+		case 0x84: ZERO_PAGE		      CYCLE_WRITE(address, Y); break;
+		case 0x8C: ABSOLUTE		      CYCLE_WRITE(address, Y); break;
+		case 0x94: ZERO_PAGE_INDEXED(X)	      CYCLE_WRITE(address, Y); break;
+		case 0x24: ZERO_PAGE		      BIT(CYCLE_READ(address)) break;
+		case 0x2C: ABSOLUTE		      BIT(CYCLE_READ(address)) break;
+		case 0xC0:			      CPY(FETCH)	       break;
+		case 0xC4: ZERO_PAGE		      CPY(CYCLE_READ(address)) break;
+		case 0xCC: ABSOLUTE		      CPY(CYCLE_READ(address)) break;
+		case 0xE0:			      CPX(FETCH)	       break;
+		case 0xE4: ZERO_PAGE		      CPX(CYCLE_READ(address)) break;
+		case 0xEC: ABSOLUTE		      CPX(CYCLE_READ(address)) break;
+
+		/* Register transfers, stack operations, increments & decrements */
+		case 0xAA: IMPLIED; X = A; SET_P_NZ(X);			     break;
+		case 0xA8: IMPLIED; Y = A; SET_P_NZ(Y);			     break;
+		case 0x8A: IMPLIED; A = X; SET_P_NZ(A);			     break;
+		case 0x98: IMPLIED; A = Y; SET_P_NZ(A);			     break;
+		case 0xBA: IMPLIED; X = S; SET_P_NZ(X);			     break;
+		case 0x9A: IMPLIED; S = X;				     break;
+		case 0x48: IMPLIED; PUSH(A);				     break;
+		case 0x08: IMPLIED; PUSH(P);				     break;
+		case 0x68: IMPLIED; DUMMY_STACK_READ; A = PULL; SET_P_NZ(A); break;
+		case 0x28: IMPLIED; DUMMY_STACK_READ; P = PULL;		     break;
+		case 0xE8: IMPLIED; X++; SET_P_NZ(X);			     break;
+		case 0xC8: IMPLIED; Y++; SET_P_NZ(Y);			     break;
+		case 0xCA: IMPLIED; X--; SET_P_NZ(X);			     break;
+		case 0x88: IMPLIED; Y--; SET_P_NZ(Y);			     break;
+
+		/* Jumps & calls */
+		case 0x4C: ABSOLUTE PC = address; break;
+
+		case 0x6C:
+		ABSOLUTE
+		value = CYCLE_READ(address);
+		PC = (zuint16)(value | CYCLE_READ(address + 1) << 8);
+		break;
+
+		case 0x20:
+		value = FETCH;
+		DUMMY_STACK_READ;
+		PUSH(PC >> 8);
+		PUSH(PC);
+		PC = (zuint16)(value | CYCLE_READ(PC) << 8);
+		break;
+
+		case 0x60:
+		IMPLIED;
+		DUMMY_STACK_READ;
+		value = PULL;
+		PC = (zuint16)(value | PULL << 8);
+		CYCLE_READ(PC++);
+		break;
+
+		/* Branches */
+		case 0x90: CYCLE_BRANCH(!(P & CP)) break;
+		case 0xB0: CYCLE_BRANCH(  P & CP ) break;
+		case 0xF0: CYCLE_BRANCH(  P & ZP ) break;
+		case 0x30: CYCLE_BRANCH(  P & NP ) break;
+		case 0xD0: CYCLE_BRANCH(!(P & ZP)) break;
+		case 0x10: CYCLE_BRANCH(!(P & NP)) break;
+		case 0x50: CYCLE_BRANCH(!(P & VP)) break;
+		case 0x70: CYCLE_BRANCH(  P & VP ) break;
+
+		/* Status flag changes & system functions */
+		case 0x18: IMPLIED; P &= ~CP; break;
+		case 0xD8: IMPLIED; P &= ~DP; break;
+		case 0x58: IMPLIED; P &= ~IP; break;
+		case 0xB8: IMPLIED; P &= ~VP; break;
+		case 0x38: IMPLIED; P |=  CP; break;
+		case 0xF8: IMPLIED; P |=  DP; break;
+		case 0x78: IMPLIED; P |=  IP; break;
+
+		case 0x40:
+		IMPLIED;
+		DUMMY_STACK_READ;
+		P = PULL;
+		value = PULL;
+		PC = (zuint16)(value | PULL << 8);
+		break;
+
+		case 0x00:
+		FETCH; /* BRK padding byte */
+		PUSH(PC >> 8);
+		PUSH(PC);
+		PUSH(P | BP);
+		P |= BP | IP;
+		value = CYCLE_READ(Z_6502_ADDRESS_BRK_POINTER);
+		PC = (zuint16)(value | CYCLE_READ(Z_6502_ADDRESS_BRK_POINTER + 1) << 8);
+		break;
+
+#		ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+			CYCLE_CASES_L(0x00, SLO) CYCLE_CASES_L(0x20, RLA) CYCLE_CASES_L(0x40, SRE)
+			CYCLE_CASES_L(0x60, RRA) CYCLE_CASES_L(0xC0, DCP) CYCLE_CASES_L(0xE0, ISC)
+
+			/* sax M, lax M, lxa, las */
+			case 0x83: INDIRECT_X		      CYCLE_WRITE(address, A & X); break;
+			case 0x87: ZERO_PAGE		      CYCLE_WRITE(address, A & X); break;
+			case 0x8F: ABSOLUTE		      CYCLE_WRITE(address, A & X); break;
+			case 0x97: ZERO_PAGE_INDEXED(Y)	      CYCLE_WRITE(address, A & X); break;
+			case 0xA3: INDIRECT_X		      LAX(CYCLE_READ(address))	   break;
+			case 0xA7: ZERO_PAGE		      LAX(CYCLE_READ(address))	   break;
+			case 0xAF: ABSOLUTE		      LAX(CYCLE_READ(address))	   break;
+			case 0xB3: INDIRECT_Y(FALSE)	      LAX(CYCLE_READ(address))	   break;
+			case 0xB7: ZERO_PAGE_INDEXED(Y)	      LAX(CYCLE_READ(address))	   break;
+			case 0xBF: ABSOLUTE_INDEXED(Y, FALSE) LAX(CYCLE_READ(address))	   break;
+			case 0xAB:			      LXA(FETCH)		   break;
+			case 0xBB: ABSOLUTE_INDEXED(Y, FALSE) LAS(CYCLE_READ(address))	   break;
+
+			/* anc, alr, arr, ane, sbx, sbc (immediate) */
+			case 0x0B:
+			case 0x2B: ANC(FETCH) break;
+			case 0x4B: ALR(FETCH) break;
+			case 0x6B: ARR(FETCH) break;
+			case 0x8B: ANE(FETCH) break;
+			case 0xCB: SBX(FETCH) break;
+			case 0xEB: SBC(FETCH) break;
+
+			/* sha, shx, shy, tas */
+			case 0x93: INDIRECT	       CYCLE_UNSTABLE_STORE(Y, A & X) break;
+			case 0x9F: ABSOLUTE	       CYCLE_UNSTABLE_STORE(Y, A & X) break;
+			case 0x9E: ABSOLUTE	       CYCLE_UNSTABLE_STORE(Y, X)     break;
+			case 0x9C: ABSOLUTE	       CYCLE_UNSTABLE_STORE(X, Y)     break;
+			case 0x9B: ABSOLUTE S = A & X; CYCLE_UNSTABLE_STORE(Y, S)     break;
+
+			/* nop with operand */
+			case 0x80: case 0x82: case 0x89: case 0xC2: case 0xE2:
+			FETCH;
+			break;
+
+			case 0x04: case 0x44: case 0x64:
+			ZERO_PAGE CYCLE_READ(address);
+			break;
+
+			case 0x14: case 0x34: case 0x54: case 0x74: case 0xD4: case 0xF4:
+			ZERO_PAGE_INDEXED(X) CYCLE_READ(address);
+			break;
+
+			case 0x0C:
+			ABSOLUTE CYCLE_READ(address);
+			break;
+
+			case 0x1C: case 0x3C: case 0x5C: case 0x7C: case 0xDC: case 0xFC:
+			ABSOLUTE_INDEXED(X, FALSE) CYCLE_READ(address);
+			break;
+
+			/* jam: the interrupts sampled during the opcode are discarded */
+			case 0x02: case 0x12: case 0x22: case 0x32: case 0x42: case 0x52:
+			case 0x62: case 0x72: case 0x92: case 0xB2: case 0xD2: case 0xF2:
+			IMPLIED;
+			PC--;
+			JAMMED = TRUE;
+			object->interrupt_poll = 0;
+			break;
+#		endif
+
+		/* nop and illegal opcodes */
+		default: IMPLIED; break;
+		}
+	}
+
+#endif
+
+
+/* MARK: - Main Functions */
+
+CPU_6502_API void m6502_power(M6502 *object, zboolean state)
+	{
+	if (state)
+		{
+		PC = Z_6502_VALUE_AFTER_POWER_ON_PC;
+		S  = Z_6502_VALUE_AFTER_POWER_ON_S;
+		P  = Z_6502_VALUE_AFTER_POWER_ON_P;
+		A  = Z_6502_VALUE_AFTER_POWER_ON_A;
+		X  = Z_6502_VALUE_AFTER_POWER_ON_X;
+		Y  = Z_6502_VALUE_AFTER_POWER_ON_Y;
+		IRQ = NMI = FALSE;
+		}
+
+	else PC = S = P = A = X = Y = IRQ = NMI = 0;
+
+#	ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+		JAMMED = FALSE;
+#	endif
+
+#	ifdef CPU_6502_WITH_CYCLE_EXACT
+		object->interrupt_poll = 0;
+#	endif
+	}
+
+
+CPU_6502_API void m6502_reset(M6502 *object)
+	{
+	PC = READ_POINTER(RESET);
+	S = Z_6502_VALUE_AFTER_POWER_ON_S;
+	P = Z_6502_VALUE_AFTER_POWER_ON_P;
+	IRQ = NMI = FALSE;
+
+#	ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+		JAMMED = FALSE;
+#	endif
+
+#	ifdef CPU_6502_WITH_CYCLE_EXACT
+		object->interrupt_poll = 0;
+#	endif
+	}
+
+
+#ifdef CPU_6502_WITH_REGISTER_CACHE
+
+	/*-------------------------------------------------------------------.
+	| When built with CPU_6502_WITH_REGISTER_CACHE, m6502_run keeps the  |
+	| registers and the cycle counter in local variables, so that the    |
+	| compiler does not have to reload them after every callback. They   |
+	| are written back to the object before returning and, only if the   |
+	| member `coherent_state` is TRUE, also before each callback. The    |
+	| following definitions apply to m6502_run only and are restored     |
+	| right after it.						     |
+	'-------------------------------------------------------------------*/
+
+#	undef REGISTERS
+#	undef CYCLES
+#	undef BUS_READ_8
+#	undef BUS_WRITE_8
+#	undef READ_16
+#	undef PUSH_16
+#	undef POP_16
+
+#	define REGISTERS registers
+#	define CYCLES	 elapsed
+
+#	ifdef CPU_6502_WITH_LAZY_FLAGS
+#		undef NZ
+#		define NZ	     lazy_nz
+#		define SAVE_LAZY_NZ object->lazy_nz = NZ,
+#	else
+#		define SAVE_LAZY_NZ
+#	endif
+
+#	define SAVE_STATE					\
+		(SAVE_LAZY_NZ					\
+		 object->state.Z_6502_STATE_MEMBER_PC = PC,	\
+		 object->state.Z_6502_STATE_MEMBER_S  = S,	\
+		 object->state.Z_6502_STATE_MEMBER_P  = P,	\
+		 object->state.Z_6502_STATE_MEMBER_A  = A,	\
+		 object->state.Z_6502_STATE_MEMBER_X  = X,	\
+		 object->state.Z_6502_STATE_MEMBER_Y  = Y,	\
+		 object->cycles = CYCLES)
+
+#	ifdef CPU_6502_WITH_DECODE_CACHE
+#		define INVALIDATE_WRITTEN_CODE INVALIDATE_CODE(bus_address),
+#	else
+#		define INVALIDATE_WRITTEN_CODE
+#	endif
+
+#	define CALLBACK_READ_8(address)						\
+		(object->coherent_state						\
+			? (SAVE_STATE, READ_CALLBACK(address))	\
+			: READ_CALLBACK(address))
+
+#	define CALLBACK_WRITE_8(address, value)						\
+		(object->coherent_state							\
+			? (SAVE_STATE, object->write(object->context, address, value))	\
+			: object->write(object->context, address, value))
+
+#	ifdef CPU_6502_WITH_PAGE_TABLE
+
+#		define BUS_READ_8(address)							\
+			(bus_address = (zuint16)(address),					\
+			 object->read_pages[bus_address >> 8] != NULL				\
+				? object->read_pages[bus_address >> 8][bus_address & 0xFF]	\
+				: CALLBACK_READ_8(bus_address))
+
+#		define BUS_WRITE_8(address, value)								\
+			(bus_address = (zuint16)(address),							\
+			 bus_value   = (zuint8)(value),								\
+			 INVALIDATE_WRITTEN_CODE								\
+			 object->write_pages[bus_address >> 8] != NULL						\
+				? (void)(object->write_pages[bus_address >> 8][bus_address & 0xFF] = bus_value) \
+				: COPY_ON_WRITE(bus_address, bus_value)					\
+					? (void)0							\
+					: CALLBACK_WRITE_8(bus_address, bus_value))
+
+#	else
+
+#		define BUS_READ_8(address) \
+			(bus_address = (zuint16)(address), CALLBACK_READ_8(bus_address))
+
+#		define BUS_WRITE_8(address, value)		\
+			(bus_address = (zuint16)(address),	\
+			 bus_value   = (zuint8)(value),		\
+			 CALLBACK_WRITE_8(bus_address, bus_value))
+
+#	endif
+
+#	if defined(CPU_6502_WITH_DECODE_CACHE) || defined(CPU_6502_WITH_FETCH)
+
+		/*-------------------------------------------------------------.
+		| Operands not pre-decoded or pre-fetched are read using their |
+		| own temporaries, since these reads can be nested in READ_8,  |
+		| WRITE_8 and READ_16.					       |
+		'-------------------------------------------------------------*/
+
+#		undef READ_OPERAND_8
+#		undef READ_OPERAND_16
+
+#		ifdef CPU_6502_WITH_PAGE_TABLE
+
+#			define READ_OPERAND_8(address)								\
+				(operand_address = (zuint16)(address),						\
+				 object->read_pages[operand_address >> 8] != NULL				\
+					? object->read_pages[operand_address >> 8][operand_address & 0xFF]	\
+					: CALLBACK_READ_8(operand_address))
+
+#		else
+
+#			define READ_OPERAND_8(address) \
+				(operand_address = (zuint16)(address), CALLBACK_READ_8(operand_address))
+
+#		endif
+
+#		define READ_OPERAND_16(address)				\
+			(operand_word = (zuint16)(address),		\
+			 operand_low  = READ_OPERAND_8(operand_word),	\
+			 (zuint16)(operand_low | (zuint16)READ_OPERAND_8(operand_word + 1) << 8))
+
+#	endif
+
+#	ifdef CPU_6502_WITH_FETCH
+#		undef FETCH_CALLBACK
+
+#		define FETCH_CALLBACK(address)						\
+			(object->coherent_state						\
+				? (SAVE_STATE, object->fetch(object->context, address))	\
+				: object->fetch(object->context, address))
+#	endif
+
+#	define READ_16(address)				\
+		(word_address = (zuint16)(address),	\
+		 word_low     = READ_8(word_address),	\
+		 (zuint16)(word_low | (zuint16)READ_8(word_address + 1) << 8))
+
+#	define PUSH_16(value)								\
+		(word_address = (zuint16)(value),					\
+		 WRITE_8(Z_6502_ADDRESS_STACK | S,		 word_address >> 8),	\
+		 WRITE_8(Z_6502_ADDRESS_STACK | (zuint8)(S - 1), word_address),		\
+		 S -= 2)
+
+#	define POP_16											\
+		(word_low     = READ_8(Z_6502_ADDRESS_STACK | (zuint8)(S + 1)),				\
+		 word_address = (zuint16)								\
+			(word_low | (zuint16)READ_8(Z_6502_ADDRESS_STACK | (zuint8)(S + 2)) << 8),	\
+		 S += 2,										\
+		 word_address)
+
+#endif
+
+
+#ifdef CPU_6502_WITH_EVENTS
+
+	/*---------------------------------------------------------------.
+	| The event queue is a binary min-heap ordered by `cycle` that	 |
+	| lives in the array provided by the host. m6502_run checks its	 |
+	| root at every instruction boundary.				 |
+	'---------------------------------------------------------------*/
+
+	static void sift_down_event(M6502Event *events, zusize count, zusize index)
+		{
+		M6502Event event = events[index];
+		zusize child;
+
+		while ((child = index * 2 + 1) < count)
+			{
+			if (child + 1 < count && events[child + 1].cycle < events[child].cycle)
+				child++;
+
+			if (event.cycle <= events[child].cycle) break;
+			events[index] = events[child];
+			index = child;
+			}
+
+		events[index] = event;
+		}
+
+
+	static void dispatch_events(M6502 *object, zusize cycles)
+		{
+		zusize clock = object->event_clock + cycles;
+		M6502Event event;
+
+		while (object->event_count && object->events->cycle <= clock)
+			{
+			event = *object->events;
+
+			if (--object->event_count)
+				{
+				*object->events = object->events[object->event_count];
+				sift_down_event(object->events, object->event_count, 0);
+				}
+
+			event.callback(object->context, event.cycle);
+			}
+		}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_RECORD_REPLAY
+
+	static void log_event(M6502 *object, zuint8 tag, zusize clock)
+		{
+		zuint index = 8;
+
+		log_byte(object, tag);
+		while (index--) {log_byte(object, (zuint8)clock); clock >>= 8;}
+		object->log[object->log_index] = LOG_READ;
+		}
+
+
+	static void log_interrupts(M6502 *object, zusize cycles)
+		{
+		zusize clock = object->log_clock + cycles, event_clock;
+		zuint  index;
+		zuint8 tag;
+
+		if (object->log_mode == M6502_LOG_MODE_RECORD)
+			{
+			if (NMI) log_event(object, LOG_NMI, clock);
+
+			if (!IRQ != !object->log_irq) log_event
+				(object, (zuint8)(LOG_IRQ + !!(object->log_irq = IRQ)), clock);
+			}
+
+		/*----------------------------------------------------------.
+		| Replay: apply the interrupt records due at this boundary. |
+		'----------------------------------------------------------*/
+		else while ((tag = object->log[object->log_index]) != LOG_READ)
+			{
+			for (event_clock = 0, index = 8; index; index--) event_clock =
+				event_clock << 8 | object->log[(object->log_index + index) % object->log_size];
+
+			if (event_clock > clock) break;
+			object->log_index = (object->log_index + 9) % object->log_size;
+			if (tag == LOG_NMI) NMI = TRUE;
+			else IRQ = tag - LOG_IRQ;
+			PENDING = TRUE;
+			}
+		}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_TRACE
+
+	/*------------------------------------------------------------------.
+	| Each trace record starts with a byte of flags followed by the	    |
+	| opcode and the number of cycles elapsed since the previous record |
+	| (LEB128). Bits 0-1 of the flags are the distance from the address |
+	| of the previous instruction (1 to 3), or 0 if the address follows |
+	| (16-bit little-endian). Bits 2-6 indicate which of A, X, Y, S and |
+	| P have changed; their new values follow in that order. Bit 7	    |
+	| indicates that the effective address follows (16-bit LE). The	    |
+	| previous record is cleared at the beginning of each buffer.	    |
+	'------------------------------------------------------------------*/
+
+#	define TRACE_NO_EA 0x10000
+
+	/*---------------------------------------------------------------.
+	| Registers that each opcode may change, with the bits of the	 |
+	| flags byte (A = 4, X = 8, Y = 16, S = 32, P = 64). It covers	 |
+	| the documented, undocumented and 65C02 instructions at once.	 |
+	| Only these registers are compared with the previous record,	 |
+	| except after an interrupt check or an event, and at the start	 |
+	| of each buffer, where all of them are.			 |
+	'---------------------------------------------------------------*/
+
+#	define TRACE_ALL_REGISTERS 0x7C
+
+	static zuint8 const trace_registers[256] = {
+/*	0     1	    2	  3	4     5	    6	  7	8     9	    A	  B	C     D	    E	  F */
+/* 0 */ 0x60, 0x44, 0x00, 0x44, 0x40, 0x44, 0x44, 0x44, 0x20, 0x44, 0x44, 0x44, 0x40, 0x44, 0x44, 0x44,
+/* 1 */ 0x00, 0x44, 0x44, 0x44, 0x40, 0x44, 0x44, 0x44, 0x40, 0x44, 0x44, 0x44, 0x40, 0x44, 0x44, 0x44,
+/* 2 */ 0x20, 0x44, 0x00, 0x44, 0x40, 0x44, 0x44, 0x44, 0x60, 0x44, 0x44, 0x44, 0x40, 0x44, 0x44, 0x44,
+/* 3 */ 0x00, 0x44, 0x44, 0x44, 0x40, 0x44, 0x44, 0x44, 0x40, 0x44, 0x44, 0x44, 0x40, 0x44, 0x44, 0x44,
+/* 4 */ 0x60, 0x44, 0x00, 0x44, 0x00, 0x44, 0x44, 0x44, 0x20, 0x44, 0x44, 0x44, 0x00, 0x44, 0x44, 0x44,
+/* 5 */ 0x00, 0x44, 0x44, 0x44, 0x00, 0x44, 0x44, 0x44, 0x40, 0x44, 0x20, 0x44, 0x00, 0x44, 0x44, 0x44,
+/* 6 */ 0x20, 0x44, 0x00, 0x44, 0x00, 0x44, 0x44, 0x44, 0x64, 0x44, 0x44, 0x44, 0x00, 0x44, 0x44, 0x44,
+/* 7 */ 0x00, 0x44, 0x44, 0x44, 0x00, 0x44, 0x44, 0x44, 0x40, 0x44, 0x70, 0x44, 0x00, 0x44, 0x44, 0x44,
+/* 8 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50, 0x40, 0x44, 0x44, 0x00, 0x00, 0x00, 0x00,
+/* 9 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x44, 0x00, 0x20, 0x20, 0x00, 0x00, 0x00, 0x00,
+/* A */ 0x50, 0x44, 0x48, 0x4C, 0x50, 0x44, 0x48, 0x4C, 0x50, 0x44, 0x48, 0x4C, 0x50, 0x44, 0x48, 0x4C,
+/* B */ 0x00, 0x44, 0x44, 0x4C, 0x50, 0x44, 0x48, 0x4C, 0x40, 0x44, 0x48, 0x6C, 0x50, 0x44, 0x48, 0x4C,
+/* C */ 0x40, 0x40, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x50, 0x40, 0x48, 0x48, 0x40, 0x40, 0x40, 0x40,
+/* D */ 0x00, 0x40, 0x40, 0x40, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x20, 0x40, 0x00, 0x40, 0x40, 0x40,
+/* E */ 0x40, 0x44, 0x00, 0x44, 0x40, 0x44, 0x40, 0x44, 0x48, 0x44, 0x00, 0x44, 0x40, 0x44, 0x40, 0x44,
+/* F */ 0x00, 0x44, 0x44, 0x44, 0x00, 0x44, 0x40, 0x44, 0x40, 0x44, 0x68, 0x44, 0x00, 0x44, 0x40, 0x44
+	};
+
+
+	static void switch_trace_buffer(M6502 *object)
+		{
+		M6502Trace *trace = object->trace;
+
+		if (trace->index)
+			{
+			trace->flush(object->context, trace->buffers[trace->buffer], trace->index);
+			trace->buffer ^= 1;
+			trace->index	 = 0;
+			}
+
+		trace->last.cycle  = 0;
+		trace->last.pc	   = 0;
+		trace->last.a	   =
+		trace->last.x	   =
+		trace->last.y	   =
+		trace->last.s	   =
+		trace->last.p	   = 0;
+		}
+
+
+	static Z_ALWAYS_INLINE void write_trace_record(M6502 *object, M6502TraceRecord const *record, zuint8 registers)
+		{
+		M6502Trace	 *trace = object->trace;
+		M6502TraceRecord *last	= &trace->last;
+		zuint8		 *data, *cursor;
+		zusize		 delta;
+		zuint16		 step;
+		zuint8		 flags;
+
+		if (trace->index + M6502_TRACE_MAXIMUM_RECORD_SIZE > trace->buffer_size)
+			switch_trace_buffer(object);
+
+		if (!trace->index) registers = TRACE_ALL_REGISTERS;
+
+		/*-------------------------------------------------------.
+		| The fields are updated one by one; copying the whole	 |
+		| record forces the compiler to reload it after each	 |
+		| byte written to the buffer, which may alias it.	 |
+		'-------------------------------------------------------*/
+		data	    = trace->buffers[trace->buffer] + trace->index;
+		cursor	    = data + 2;
+		delta	    = record->cycle - last->cycle;
+		step	    = (zuint16)(record->pc - last->pc);
+		flags	    = step && step < 4 ? (zuint8)step : 0;
+		last->cycle = record->cycle;
+		last->pc    = record->pc;
+
+		data[1] = record->opcode;
+		for (; delta > 0x7F; delta >>= 7) *cursor++ = (zuint8)(delta | 0x80);
+		*cursor++ = (zuint8)delta;
+
+		if (!flags)
+			{
+			*cursor++ = (zuint8)record->pc;
+			*cursor++ = (zuint8)(record->pc >> 8);
+			}
+
+		if ((registers &  4) && record->a != last->a) {flags |=  4; *cursor++ = last->a = record->a;}
+		if ((registers &  8) && record->x != last->x) {flags |=  8; *cursor++ = last->x = record->x;}
+		if ((registers & 16) && record->y != last->y) {flags |= 16; *cursor++ = last->y = record->y;}
+		if ((registers & 32) && record->s != last->s) {flags |= 32; *cursor++ = last->s = record->s;}
+		if ((registers & 64) && record->p != last->p) {flags |= 64; *cursor++ = last->p = record->p;}
+
+		if (record->has_ea)
+			{
+			flags |= 128;
+			*cursor++ = (zuint8)record->ea;
+			*cursor++ = (zuint8)(record->ea >> 8);
+			}
+
+		data[0] = flags;
+		trace->index += (zusize)(cursor - data);
+		}
+
+
+#	define TRACE_INSTRUCTION					\
+		(trace_record.cycle  = object->trace->clock + CYCLES,	\
+		 trace_record.pc     = trace_pc,			\
+		 trace_record.ea     = (zuint16)trace_ea,		\
+		 trace_record.has_ea = trace_ea != TRACE_NO_EA,		\
+		 trace_record.opcode = hook_opcode,			\
+		 trace_record.a	     = A,				\
+		 trace_record.x	     = X,				\
+		 trace_record.y	     = Y,				\
+		 trace_record.s	     = S,				\
+		 trace_record.p	     = MATERIALIZED_P,			\
+		 write_trace_record(					\
+			object, &trace_record,				\
+			trace_registers[hook_opcode] | trace_forced),	\
+		 trace_forced = 0)
+
+#	define TRACE_ACCESS(kind) \
+		(traced && (kind) == M6502_ACCESS_DATA ? (void)(trace_ea = hook_address) : (void)0),
+
+#else
+#	define TRACE_ACCESS(kind)
+#endif
+
+
+#ifdef CPU_6502_WITH_BREAKPOINTS
+
+	/*-----------------------------------------------------------.
+	| The breakpoints are checked in the copy of m6502_run that  |
+	| calls the hooks. A watchpoint hit does not interrupt the   |
+	| instruction; it is recorded and the execution stops before |
+	| the next one.						     |
+	'-----------------------------------------------------------*/
+
+#	define BREAKPOINT_NO_ADDRESS 0x10000
+
+#	define BREAKPOINT_IS_SET(bitmap, address) \
+		(breakpoints->bitmap[(address) >> 3] & (1 << ((address) & 7)))
+
+#	define BREAKPOINT_IS_HIT(reason, address) \
+		(breakpoints->condition == NULL || (SYNC_STATE breakpoints->condition(object->context, reason, address)))
+
+#	define WATCH_ACCESS(bitmap, reason)						\
+		(hooked && breakpoints != NULL && !stop_reason &&			\
+		 BREAKPOINT_IS_SET(bitmap, hook_address)	 &&			\
+		 BREAKPOINT_IS_HIT(reason, hook_address)				\
+			? (void)(stop_reason = reason, stop_address = hook_address)	\
+			: (void)0),
+
+#else
+#	define WATCH_ACCESS(bitmap, reason)
+#endif
+
+
+#ifdef CPU_6502_WITH_FAST_FORWARD
+
+	/*-------------------------------------------------------------------.
+	| m6502_run fast-forwards these idle loops:			     |
+	|								     |
+	| jmp * / bxx *                  Jump or taken branch to itself.     |
+	| dex, dey, inx or iny / bne *-1 Delay loop until the register is 0. |
+	| lda or bit M / bxx *-2 or *-3  Polling loop, while the branch is   |
+	|                                taken (M is zero page or absolute). |
+	|								     |
+	| The loop and the polled byte must be in pages backed by host	     |
+	| memory, so skipping their reads has no side effects. Inside the    |
+	| loop, nothing else can change that byte or the interrupt lines,    |
+	| so the iterations are skipped until the end of the call or the     |
+	| next event, and the registers are left as stepping would leave     |
+	| them. The copies of m6502_run that report the execution do not     |
+	| fast-forward.							     |
+	'-------------------------------------------------------------------*/
+
+#	define IDLE_LOOP_JUMP	 1
+#	define IDLE_LOOP_DELAY	 2
+#	define IDLE_LOOP_POLLING 3
+
+	typedef struct {
+		zuint8 const *operand; /* Polled byte.				    */
+		zuint8	     kind;
+		zuint8	     opcode;   /* Opcode of the first instruction.	    */
+		zuint8	     branch;   /* Opcode of the last instruction.	    */
+		zuint8	     cycles;   /* Cycles per iteration.			    */
+		zuint8	     last;     /* Cycles before the last instruction starts. */
+	} IdleLoop;
+
+
+	static zuint8 const branch_flags[4] = {NP, VP, CP, ZP};
+
+#	define BRANCH_TAKEN(opcode, p) \
+		(!((p) & branch_flags[(opcode) >> 6]) == !((opcode) & 0x20))
+
+#	define BRANCH_CYCLES(pc, target) \
+		((zuint16)(pc) >> 8 == (target) >> 8 ? 3 : 4)
+
+
+	static zboolean find_idle_loop(M6502 const *object, zuint16 pc, IdleLoop *loop)
+		{
+		zuint8 const *page	= object->read_pages[pc >> 8];
+		zuint8 const *next_page = object->read_pages[(zuint16)(pc + 4) >> 8];
+		zuint8 code[5];
+		zuint  index;
+
+		if (page == NULL || next_page == NULL) return FALSE;
+
+		switch (page[pc & 0xFF])
+			{
+			case 0x4C: case 0x10: case 0x30: case 0x50: case 0x70:
+			case 0x90: case 0xB0: case 0xD0: case 0xF0: case 0xCA:
+			case 0x88: case 0xE8: case 0xC8: case 0xA5: case 0x24:
+			case 0xAD: case 0x2C: break;
+			default: return FALSE;
+			}
+
+		for (index = 0; index < 5; index++) code[index] =
+			((zuint16)(pc + index) >> 8 == pc >> 8 ? page : next_page)[(pc + index) & 0xFF];
+
+		loop->opcode = loop->branch = code[0];
+		loop->last   = 0;
+
+		if (code[0] == 0x4C && (code[1] | code[2] << 8) == pc)
+			{
+			loop->kind   = IDLE_LOOP_JUMP;
+			loop->cycles = 3;
+			return TRUE;
+			}
+
+		if ((code[0] & 0x1F) == 0x10 && code[1] == 0xFE)
+			{
+			loop->kind   = IDLE_LOOP_JUMP;
+			loop->cycles = BRANCH_CYCLES(pc + 2, pc);
+			return TRUE;
+			}
+
+		if (	(code[0] == 0xCA || code[0] == 0x88 || code[0] == 0xE8 || code[0] == 0xC8) &&
+			code[1] == 0xD0 && code[2] == 0xFD
+		)
+			{
+			loop->kind   = IDLE_LOOP_DELAY;
+			loop->branch = 0xD0;
+			loop->last   = 2;
+			loop->cycles = 2 + BRANCH_CYCLES(pc + 3, pc);
+			return TRUE;
+			}
+
+		if ((code[0] == 0xA5 || code[0] == 0x24) && (code[2] & 0x1F) == 0x10 && code[3] == 0xFC)
+			{
+			if ((loop->operand = object->read_pages[0]) == NULL) return FALSE;
+			loop->kind     = IDLE_LOOP_POLLING;
+			loop->operand += code[1];
+			loop->branch   = code[2];
+			loop->last     = 3;
+			loop->cycles   = 3 + BRANCH_CYCLES(pc + 4, pc);
+			return TRUE;
+			}
+
+		if ((code[0] == 0xAD || code[0] == 0x2C) && (code[3] & 0x1F) == 0x10 && code[4] == 0xFB)
+			{
+			if ((loop->operand = object->read_pages[code[2]]) == NULL) return FALSE;
+			loop->kind     = IDLE_LOOP_POLLING;
+			loop->operand += code[1];
+			loop->branch   = code[3];
+			loop->last     = 4;
+			loop->cycles   = 4 + BRANCH_CYCLES(pc + 5, pc);
+			return TRUE;
+			}
+
+		return FALSE;
+		}
+
+
+#	if defined(CPU_6502_WITH_TRACE)
+#		define FAST_FORWARD_OBSERVED (hooked || traced)
+#	elif defined(CPU_6502_WITH_HOOKS)
+#		define FAST_FORWARD_OBSERVED hooked
+#	else
+#		define FAST_FORWARD_OBSERVED FALSE
+#	endif
+
+#	ifdef CPU_6502_WITH_RECORD_REPLAY
+#		define FAST_FORWARD_ALLOWED (!FAST_FORWARD_OBSERVED && !object->log_mode)
+#	else
+#		define FAST_FORWARD_ALLOWED !FAST_FORWARD_OBSERVED
+#	endif
+
+#endif
+
+
+#ifdef CPU_6502_WITH_HOOKS
+
+	/*-----------------------------------------------------------------.
+	| When built with CPU_6502_WITH_HOOKS, m6502_run is compiled twice |
+	| from the same code: once with the hooks and once without them.   |
+	| `hooked` is a constant in each copy, so the calls to the hooks   |
+	| are removed from the copy used when the member `hooks` is NULL.  |
+	| CPU_6502_WITH_TRACE adds a third copy that only writes the trace |
+	| (`traced` is also a constant in it).				   |
+	| Every access is reported with its kind, so the definitions of    |
+	| the macros that access memory are replaced here. They apply to   |
+	| m6502_run only and are restored right after it.		   |
+	'-----------------------------------------------------------------*/
+
+#	ifdef CPU_6502_WITH_REGISTER_CACHE
+#		define SYNC_STATE SAVE_STATE,
+#	else
+#		define SYNC_STATE
+#	endif
+
+	/*-------------------------------------------------------------.
+	| The copy that calls the hooks also runs for the breakpoints, |
+	| m6502_run_until and the profiler, in which case `hooks` can  |
+	| be NULL.						       |
+	'-------------------------------------------------------------*/
+
+	static M6502Hooks const no_hooks;
+
+	static Z_INLINE zuint8 report_read(void (* hook)(void *context, zuint16 address, zuint8 value, zuint8 kind), void *context, zuint16 address, zuint8 value, zuint8 kind)
+		{
+		if (hook != NULL) hook(context, address, value, kind);
+		return value;
+		}
+
+
+#	define CALL_HOOK(name, arguments) \
+		(hooks->name != NULL ? (SYNC_STATE hooks->name arguments) : (void)0)
+
+#	define REPORT_READ(hook, address, kind) \
+		(SYNC_STATE report_read(hooks->hook, object->context, address, BUS_READ_8(address), kind))
+
+#	define HOOKED_READ_8(address, kind, hook)	\
+		(hook_address = (zuint16)(address),	\
+		 TRACE_ACCESS(kind)			\
+		 WATCH_ACCESS(read, M6502_BREAK_READ)	\
+		 hooked ? REPORT_READ(hook, hook_address, kind) : BUS_READ_8(hook_address))
+
+#	define HOOKED_READ_16(address, kind, hook)				\
+		(word_address = (zuint16)(address),				\
+		 word_low     = HOOKED_READ_8(word_address, kind, hook),	\
+		 (zuint16)(word_low | (zuint16)HOOKED_READ_8(word_address + 1, kind, hook) << 8))
+
+#	define HOOKED_WRITE_8(address, value, kind)	\
+		(hook_address = (zuint16)(address),	\
+		 hook_value   = (zuint8)(value),	\
+		 BUS_WRITE_8(hook_address, hook_value), \
+		 TRACE_ACCESS(kind)			\
+		 WATCH_ACCESS(write, M6502_BREAK_WRITE) \
+		 hooked ? CALL_HOOK(on_data_write, (object->context, hook_address, hook_value, kind)) : (void)0)
+
+#	define HOOKED_OPCODE											\
+		(hook_opcode = BUS_READ_8(PC),									\
+		 hooked	? (CALL_HOOK(on_fetch,	     (object->context, PC, hook_opcode, M6502_ACCESS_OPCODE)),	\
+			   CALL_HOOK(on_instruction, (object->context, PC, hook_opcode)))			\
+			: (void)0,										\
+		 hook_opcode)
+
+	/*-------------------------------------------------------------.
+	| Operands are read using their own temporaries, since these   |
+	| reads can be nested in READ_8, WRITE_8 and READ_16.	       |
+	'-------------------------------------------------------------*/
+
+#	define FETCH_8(address)								\
+		(operand_address = (zuint16)(address),					\
+		 hooked	? REPORT_READ(on_fetch, operand_address, M6502_ACCESS_OPERAND)	\
+			: BUS_READ_8(operand_address))
+
+#	define FETCH_16(address)			\
+		(operand_word = (zuint16)(address),	\
+		 operand_low  = FETCH_8(operand_word),	\
+		 (zuint16)(operand_low | (zuint16)FETCH_8(operand_word + 1) << 8))
+
+#	undef READ_8
+#	undef WRITE_8
+#	undef READ_16
+#	undef READ_POINTER
+#	undef PUSH_8
+#	undef POP_8
+#	undef PUSH_16
+#	undef POP_16
+#	undef FETCH_OPCODE
+
+#	define READ_8(address)		   HOOKED_READ_8 (address, M6502_ACCESS_DATA, on_data_read)
+#	define WRITE_8(address, value)	   HOOKED_WRITE_8(address, value, M6502_ACCESS_DATA)
+#	define READ_16(address)		   HOOKED_READ_16(address, M6502_ACCESS_DATA, on_data_read)
+#	define READ_POINTER(pointer_name) \
+		HOOKED_READ_16(Z_6502_ADDRESS_##pointer_name##_POINTER, M6502_ACCESS_VECTOR, on_data_read)
+
+#	define PUSH_8(value) HOOKED_WRITE_8(Z_6502_ADDRESS_STACK + S--, value, M6502_ACCESS_STACK);
+#	define POP_8	     HOOKED_READ_8 (Z_6502_ADDRESS_STACK + ++S, M6502_ACCESS_STACK, on_data_read)
+
+#	define PUSH_16(value)												\
+		(word_address = (zuint16)(value),									\
+		 HOOKED_WRITE_8(Z_6502_ADDRESS_STACK | S,		 word_address >> 8, M6502_ACCESS_STACK),	\
+		 HOOKED_WRITE_8(Z_6502_ADDRESS_STACK | (zuint8)(S - 1), word_address, M6502_ACCESS_STACK),		\
+		 S -= 2)
+
+#	define POP_16														\
+		(word_low     = HOOKED_READ_8(Z_6502_ADDRESS_STACK | (zuint8)(S + 1), M6502_ACCESS_STACK, on_data_read),	\
+		 word_address = (zuint16)											\
+			(word_low | (zuint16)HOOKED_READ_8									\
+				(Z_6502_ADDRESS_STACK | (zuint8)(S + 2), M6502_ACCESS_STACK, on_data_read) << 8),		\
+		 S += 2,													\
+		 word_address)
+
+#	if defined(CPU_6502_WITH_DECODE_CACHE) || defined(CPU_6502_WITH_FETCH)
+
+		/*--------------------------------------------------------------.
+		| The decode cache and the fetch callback are bypassed while	|
+		| the hooks are active, so that all the fetches are reported.	|
+		'--------------------------------------------------------------*/
+
+#		undef READ_OPERAND_8
+#		undef READ_OPERAND_16
+
+#		define READ_OPERAND_8  FETCH_8
+#		define READ_OPERAND_16 FETCH_16
+
+#		define FETCH_OPCODE							\
+			(!hooked && (	(instruction = CACHED_INSTRUCTION)  != NULL ||	\
+					(instruction = FETCHED_INSTRUCTION) != NULL)	\
+				? (hook_opcode = instruction->opcode)			\
+				: (instruction = NULL, HOOKED_OPCODE))
+
+#	else
+#		undef BYTE_OPERAND
+#		undef WORD_OPERAND
+#		undef READ_BYTE_OPERAND
+#		undef READ_WORD_OPERAND
+
+#		define BYTE_OPERAND	 FETCH_8 (PC + 1)
+#		define WORD_OPERAND	 FETCH_16(PC + 1)
+#		define READ_BYTE_OPERAND FETCH_8 ((PC += 2) - 1)
+#		define READ_WORD_OPERAND FETCH_16((PC += 3) - 2)
+#		define FETCH_OPCODE	 HOOKED_OPCODE
+#	endif
+
+#endif
+
+
+/*---------------------------------------------------------------.
+| CPU_6502_WITH_EAGER_INTERRUPT_CHECK makes m6502_run check the	 |
+| interrupt lines before every instruction, as it did before the |
+| introduction of interrupt_pending, so that benchmark-6502 can	 |
+| measure the cost of doing so.					 |
+'---------------------------------------------------------------*/
+
+#ifdef CPU_6502_WITH_EAGER_INTERRUPT_CHECK
+#	define INTERRUPT_CHECK_NEEDED TRUE
+#	define INTERRUPT_CHECK_DONE
+#else
+#	define INTERRUPT_CHECK_NEEDED PENDING
+#	define INTERRUPT_CHECK_DONE   PENDING = FALSE;
+#endif
+
+
+/*-----------------------------------------------------------------.
+| m6502_run and m6502_step are compiled from the same code. `step` |
+| is a constant in each copy: when it is TRUE, the loop makes a	   |
+| single pass, which executes one instruction or accepts one	   |
+| interrupt, and the idle loops are not looked for.		   |
+'-----------------------------------------------------------------*/
+
+#if defined(CPU_6502_WITH_TRACE)
+	static Z_ALWAYS_INLINE zusize run(M6502 *object, zusize cycles, zboolean step, zboolean hooked, zboolean traced)
+#elif defined(CPU_6502_WITH_HOOKS)
+	static Z_ALWAYS_INLINE zusize run(M6502 *object, zusize cycles, zboolean step, zboolean hooked)
+#else
+	static Z_ALWAYS_INLINE zusize run(M6502 *object, zusize cycles, zboolean step)
+#endif
 	{
+#	ifdef CPU_6502_WITH_SWITCH_DISPATCH
+		zuint16 address;
+		zuint8	penalty, instruction_cycles;
+#	endif
+
+#	if defined(CPU_6502_WITH_DECODE_CACHE) || defined(CPU_6502_WITH_FETCH)
+		M6502DecodedInstruction const *instruction;
+#	endif
+
+#	ifdef CPU_6502_WITH_FETCH
+		M6502DecodedInstruction fetched;
+		zuint32			fetched_bytes;
+#	endif
+
+#	ifdef CPU_6502_WITH_REGISTER_CACHE
+		Z6502State registers = object->state;
+		zusize	   elapsed;
+		zuint16	   bus_address;
+		zuint8	   bus_value;
+#	endif
+
+#	if defined(CPU_6502_WITH_REGISTER_CACHE) || defined(CPU_6502_WITH_HOOKS)
+		zuint16 word_address;
+		zuint8	word_low;
+#	endif
+
+#	if	(defined(CPU_6502_WITH_REGISTER_CACHE) &&				   \
+		 (defined(CPU_6502_WITH_DECODE_CACHE) || defined(CPU_6502_WITH_FETCH))) || \
+		defined(CPU_6502_WITH_HOOKS)
+		zuint16 operand_address, operand_word;
+		zuint8	operand_low;
+#	endif
+
+#	if defined(CPU_6502_WITH_REGISTER_CACHE) && defined(CPU_6502_WITH_LAZY_FLAGS)
+		zuint16 lazy_nz;
+#	endif
+
+#	ifdef CPU_6502_WITH_HOOKS
+		M6502Hooks const *hooks = object->hooks != NULL ? object->hooks : &no_hooks;
+		zuint16		  hook_address;
+		zuint8		  hook_value, hook_opcode;
+#	endif
+
+#	ifdef CPU_6502_WITH_BREAKPOINTS
+		M6502Breakpoints *breakpoints	 = object->breakpoints;
+		zuint32		 resume_address =
+			breakpoints != NULL && breakpoints->reason == M6502_BREAK_EXECUTE
+				? breakpoints->address : BREAKPOINT_NO_ADDRESS;
+		zuint16		 stop_address	 = 0;
+		zuint8		 stop_reason	 = M6502_BREAK_NONE;
+#	endif
+
+#	ifdef CPU_6502_WITH_RUN_UNTIL
+		M6502Until *until = object->until;
+#	endif
+
+#	ifdef CPU_6502_WITH_PROFILER
+		M6502Profile *profile = object->profile;
+		zusize	      profile_cycles;
+#	endif
+
+#	ifdef CPU_6502_WITH_FAST_FORWARD
+		IdleLoop idle_loop;
+		zusize	 limit, iterations;
+		zuint32	 idle_miss = 0x10000;
+		zuint16	 idle_pc   = 0xFFFF;
+		zuint8	 idle_value, idle_p;
+#	endif
+
+#	ifdef CPU_6502_WITH_TRACE
+		M6502TraceRecord trace_record;
+		zuint32		 trace_ea;
+		zuint16		 trace_pc;
+		zuint8		 trace_forced = TRACE_ALL_REGISTERS;
+#	endif
+
 	/*-------------.
 	| Clear cycles |
 	'-------------*/
 	CYCLES = 0;
 
-	/*------------------------------.
-	| Execute until cycles consumed |
-	'------------------------------*/
-	while (CYCLES < cycles)
+	/*-------------------------------------------------.
+	| The host may have changed the interrupt lines or |
+	| P since the last call, so check them first.	   |
+	'-------------------------------------------------*/
+	PENDING = TRUE;
+	NZ_FROM_P
+
+	/*------------------------------------------------------.
+	| Execute until cycles consumed. Every pass consumes at |
+	| least 1 cycle, so a step ends after the first one.	|
+	'------------------------------------------------------*/
+	while (step ? !CYCLES : CYCLES < cycles)
 		{
-		/*--------------------------------------.
-		| Jump to NMI handler if NMI pending... |
-		'--------------------------------------*/
-		if (NMI)
+#		ifdef CPU_6502_WITH_BREAKPOINTS
+			if (hooked && stop_reason) break;
+#		endif
+
+#		ifdef CPU_6502_WITH_EVENTS
+			if (	object->event_count &&
+				object->events->cycle <= object->event_clock + CYCLES
+			)
+				{
+#				ifdef CPU_6502_WITH_REGISTER_CACHE
+					if (object->coherent_state) SAVE_STATE;
+#				endif
+
+				dispatch_events(object, CYCLES);
+
+#				ifdef CPU_6502_WITH_TRACE
+					trace_forced = TRACE_ALL_REGISTERS;
+#				endif
+				}
+#		endif
+
+#		ifdef CPU_6502_WITH_RECORD_REPLAY
+			if (object->log_mode) log_interrupts(object, CYCLES);
+#		endif
+
+#		ifdef CPU_6502_WITH_CYCLE_EXACT
+			cycle_exact_step(object);
+#		else
+
+		/*-------------------------------------------------------------.
+		| The interrupt lines are only checked after an event that may |
+		| have made an interrupt acceptable: a change on the lines, or |
+		| an instruction that may have cleared the I flag.	       |
+		'-------------------------------------------------------------*/
+		if (INTERRUPT_CHECK_NEEDED)
 			{
-			NMI = FALSE;		/* Clear the NMI pulse.				       */
-			P &= ~BP;
-			PUSH_16(PC);		/* Save return addres in the stack.		       */
-			PUSH_8(P);		/* Save current status in the stack.		       */
-			PC = READ_POINTER(NMI); /* Make PC point to the NMI routine.		       */
-			P |= IP;		/* Disable interrupts to don't bother the NMI routine. */
-			CYCLES += 7;		/* Accepting a NMI consumes 7 ticks.		       */
-			continue;
+#			ifdef CPU_6502_WITH_TRACE
+				trace_forced = TRACE_ALL_REGISTERS;
+#			endif
+
+			/*--------------------------------------.
+			| Jump to NMI handler if NMI pending... |
+			'--------------------------------------*/
+			if (NMI && !JAMMED)
+				{
+				NMI = FALSE; /* Clear the NMI pulse. */
+				ACCEPT_INTERRUPT(READ_POINTER(NMI))
+				continue;
+				}
+
+			/*--------------------------.
+			| Execute IRQ if pending... |
+			'--------------------------*/
+			if (IRQ && !(P & IP) && !JAMMED)
+				{
+				ACCEPT_INTERRUPT(READ_POINTER(IRQ))
+				continue;
+				}
+
+			INTERRUPT_CHECK_DONE
 			}
 
-		/*--------------------------.
-		| Execute IRQ if pending... |
-		'--------------------------*/
-		if (IRQ && !(P & IP))
-			{
-			P &= ~BP;
-			PUSH_16(PC);
-			PUSH_8(P);
-			PC = READ_POINTER(IRQ);
-			P |= IP;
-			CYCLES += 7;
-			continue;
-			}
+#		ifdef CPU_6502_WITH_FAST_FORWARD
+			/*------------------------------------------------------.
+			| Idle loops are only looked for after a jump or branch |
+			| backwards, and at the first instruction of each call. |
+			| The last address where none was found is remembered,	|
+			| so that the top of an ordinary loop is checked once.	|
+			'------------------------------------------------------*/
+			if (	!step && FAST_FORWARD_ALLOWED && PC <= idle_pc && PC != idle_miss &&
+				(find_idle_loop(object, PC, &idle_loop) || (idle_miss = PC, FALSE))
+			)
+				{
+				/*-------------------------------------------------------.
+				| Every instruction of the skipped iterations must start |
+				| before the end of the call and before the next event.	 |
+				'-------------------------------------------------------*/
+				limit = cycles;
+
+#				ifdef CPU_6502_WITH_EVENTS
+					if (	object->event_count &&
+						object->events->cycle - object->event_clock < limit
+					)
+						limit = object->events->cycle - object->event_clock;
+#				endif
+
+				iterations = limit - CYCLES > idle_loop.last
+					? (limit - CYCLES - idle_loop.last - 1) / idle_loop.cycles + 1
+					: 0;
+
+				switch (idle_loop.kind)
+					{
+					case IDLE_LOOP_JUMP:
+					if (idle_loop.opcode != 0x4C && !BRANCH_TAKEN(idle_loop.branch, MATERIALIZED_P))
+						iterations = 0;
+					break;
+
+					/*-----------------------------------------------.
+					| The last iteration, in which bne is not taken, |
+					| is always executed normally.			 |
+					'-----------------------------------------------*/
+					case IDLE_LOOP_DELAY:
+					idle_value = idle_loop.opcode == 0xCA || idle_loop.opcode == 0xE8 ? X : Y;
+
+					if (idle_loop.opcode == 0xCA || idle_loop.opcode == 0x88)
+						{
+						if (iterations > (zuint8)(idle_value - 1)) iterations = (zuint8)(idle_value - 1);
+						idle_value = (zuint8)(idle_value - iterations);
+						}
+
+					else	{
+						if (iterations > (zuint8)~idle_value) iterations = (zuint8)~idle_value;
+						idle_value = (zuint8)(idle_value + iterations);
+						}
+
+					if (iterations)
+						{
+						if (idle_loop.opcode == 0xCA || idle_loop.opcode == 0xE8) X = idle_value;
+						else Y = idle_value;
+						SET_P_NZ(idle_value);
+						}
+					break;
+
+					/*------------------------------------------------.
+					| The polled byte cannot change inside the loop,  |
+					| so the branch is taken in every iteration or in |
+					| none of them.					  |
+					'------------------------------------------------*/
+					case IDLE_LOOP_POLLING:
+					idle_value = *idle_loop.operand;
+					idle_p	   = MATERIALIZED_P;
+
+					if (idle_loop.opcode & 0x80) idle_p = (zuint8)
+						((idle_p & ~NZP) | (idle_value & NP) | ZP_ZERO(idle_value));
+
+					else idle_p = (zuint8)
+						((idle_p & ~(NZP | VP)) | (idle_value & (NP | VP)) | ZP_ZERO(idle_value & A));
+
+					if (!BRANCH_TAKEN(idle_loop.branch, idle_p)) iterations = 0;
+
+					else if (iterations)
+						{
+						if (idle_loop.opcode & 0x80)
+							{
+							A = idle_value;
+							SET_P_NZ(idle_value);
+							}
+
+						else	{
+							P = (P & ~VP) | (idle_value & VP);
+							SET_P_N_Z(idle_value, idle_value & A);
+							}
+						}
+					break;
+					}
+
+				if (iterations)
+					{
+					CYCLES += iterations * idle_loop.cycles;
+					continue;
+					}
+				}
+
+			idle_pc = PC;
+#		endif
 
 		/*-----------------------------------------------.
 		| Execute instruction and update consumed cycles |
 		'-----------------------------------------------*/
-		CYCLES += instruction_table[OPCODE = READ_8(PC)](object);
+#		ifdef CPU_6502_WITH_SWITCH_DISPATCH
+#			ifdef CPU_6502_WITH_BREAKPOINTS
+				if (hooked && breakpoints != NULL)
+					{
+					if (	PC != resume_address		&&
+						BREAKPOINT_IS_SET(execute, PC)	&&
+						BREAKPOINT_IS_HIT(M6502_BREAK_EXECUTE, PC)
+					)
+						{
+						stop_reason  = M6502_BREAK_EXECUTE;
+						stop_address = PC;
+						break;
+						}
+
+					resume_address = BREAKPOINT_NO_ADDRESS;
+					}
+#			endif
+
+#			ifdef CPU_6502_WITH_PROFILER
+				if (hooked && profile != NULL)
+					{
+					profile->pc_hits[PC]++;
+					profile_cycles = CYCLES;
+					penalty	       = 0;
+					}
+#			endif
+
+#			ifdef CPU_6502_WITH_TRACE
+				trace_pc = PC;
+				trace_ea = TRACE_NO_EA;
+#			endif
+
+			SWITCH_DISPATCH
+			CYCLES += instruction_cycles;
+
+#			ifdef CPU_6502_WITH_PROFILER
+				if (hooked && profile != NULL)
+					{
+					profile->executions    [hook_opcode]++;
+					profile->cycles	       [hook_opcode] += CYCLES - profile_cycles;
+					profile->page_crossings[hook_opcode] += penalty;
+
+					/*-----------------------------------------------.
+					| Conditional branches take 2 cycles when they	 |
+					| are not taken, and 3 or 4 cycles otherwise.	 |
+					'-----------------------------------------------*/
+					if ((hook_opcode & 0x1F) == 0x10)
+						{
+						if (instruction_cycles == 2) profile->branches_not_taken[hook_opcode]++;
+						else profile->branches_taken[hook_opcode]++;
+						}
+					}
+#			endif
+
+#			ifdef CPU_6502_WITH_TRACE
+				if (traced) TRACE_INSTRUCTION;
+#			endif
+
+#			ifdef CPU_6502_WITH_RUN_UNTIL
+				if (hooked && until != NULL)
+					{
+					if (	(until->conditions & M6502_UNTIL_INSTRUCTIONS) &&
+						!--until->instructions
+					)
+						until->reason = M6502_UNTIL_INSTRUCTIONS;
+
+					else if (
+						(until->conditions & M6502_UNTIL_RETURN)   &&
+						(hook_opcode == 0x60 || hook_opcode == 0x40) &&
+						S >= until->frame
+					)
+						until->reason = M6502_UNTIL_RETURN;
+
+					else if ((until->conditions & M6502_UNTIL_PC) && PC == until->pc)
+						until->reason = M6502_UNTIL_PC;
+
+					if (until->reason) break;
+					}
+#			endif
+#		else
+			CYCLES += instruction_table[OPCODE = READ_8(PC)](object);
+#		endif
+#		endif
 		}
 
+	P_FROM_NZ
+
+#	ifdef CPU_6502_WITH_REGISTER_CACHE
+		SAVE_STATE;
+#	endif
+
+#	ifdef CPU_6502_WITH_BREAKPOINTS
+		if (hooked && breakpoints != NULL)
+			{
+			breakpoints->reason  = stop_reason;
+			breakpoints->address = stop_address;
+			}
+#	endif
+
+#	ifdef CPU_6502_WITH_EVENTS
+		object->event_clock += CYCLES;
+#	endif
+
+#	ifdef CPU_6502_WITH_RECORD_REPLAY
+		object->log_clock += CYCLES;
+#	endif
+
+#	ifdef CPU_6502_WITH_TRACE
+		if (traced) object->trace->clock += CYCLES;
+#	endif
+
 	return CYCLES;
 	}
 
 
-CPU_6502_API void m6502_nmi(M6502 *object)		   {NMI = TRUE ;}
-CPU_6502_API void m6502_irq(M6502 *object, zboolean state) {IRQ = state;}
+#ifdef CPU_6502_WITH_HOOKS
+
+	/*------------------------------------------------------------.
+	| Chooses the copy of the loop for the members of the object: |
+	| the one with the hooks if any of them is used, or else the  |
+	| one that writes the trace or the one without either.	      |
+	'------------------------------------------------------------*/
+
+	static Z_ALWAYS_INLINE zusize select_run(M6502 *object, zusize cycles, zboolean step)
+		{
+		zboolean hooked = object->hooks != NULL;
+
+#		ifdef CPU_6502_WITH_BREAKPOINTS
+			if (object->breakpoints != NULL) hooked = TRUE;
+#		endif
+
+#		ifdef CPU_6502_WITH_PROFILER
+			if (object->profile != NULL) hooked = TRUE;
+#		endif
+
+#		ifdef CPU_6502_WITH_RUN_UNTIL
+			object->until = NULL;
+#		endif
+
+#		ifdef CPU_6502_WITH_TRACE
+			return hooked
+				? run(object, cycles, step, TRUE, object->trace != NULL)
+				: object->trace != NULL
+					? run(object, cycles, step, FALSE, TRUE)
+					: run(object, cycles, step, FALSE, FALSE);
+#		else
+			return hooked
+				? run(object, cycles, step, TRUE)
+				: run(object, cycles, step, FALSE);
+#		endif
+		}
+
+
+	CPU_6502_API zusize m6502_run(M6502 *object, zusize cycles)
+		{return select_run(object, cycles, FALSE);}
+
+
+	CPU_6502_API zusize m6502_step(M6502 *object)
+		{return select_run(object, 0, TRUE);}
+
+#	ifdef CPU_6502_WITH_RUN_UNTIL
+
+		CPU_6502_API zusize m6502_run_until(M6502 *object, zusize cycles, M6502Until *until)
+			{
+			until->reason = 0;
+			object->until = until;
+
+#			ifdef CPU_6502_WITH_TRACE
+				cycles = run(object, cycles, FALSE, TRUE, object->trace != NULL);
+#			else
+				cycles = run(object, cycles, FALSE, TRUE);
+#			endif
+
+			object->until = NULL;
+			return cycles;
+			}
+
+#	endif
+
+#else
+
+	CPU_6502_API zusize m6502_run(M6502 *object, zusize cycles)
+		{return run(object, cycles, FALSE);}
+
+
+	CPU_6502_API zusize m6502_step(M6502 *object)
+		{return run(object, 0, TRUE);}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_HOOKS
+
+#	undef READ_8
+#	undef WRITE_8
+#	undef READ_16
+#	undef READ_POINTER
+#	undef PUSH_8
+#	undef POP_8
+#	undef PUSH_16
+#	undef POP_16
+
+#	define READ_8			   BUS_READ_8
+#	define WRITE_8			   BUS_WRITE_8
+#	define READ_16(address)		   read_16bit(object, (zuint16)(address))
+#	define READ_POINTER(pointer_name) READ_16(Z_6502_ADDRESS_##pointer_name##_POINTER)
+#	define PUSH_8(value)		   WRITE_8(Z_6502_ADDRESS_STACK + S--, value);
+#	define POP_8			   READ_8 (Z_6502_ADDRESS_STACK + ++S)
+#	define PUSH_16(value)		   push_16bit(object, value)
+#	define POP_16			   pop_16bit(object)
+
+#	if defined(CPU_6502_WITH_DECODE_CACHE) || defined(CPU_6502_WITH_FETCH)
+#		undef READ_OPERAND_8
+#		undef READ_OPERAND_16
+#		define READ_OPERAND_8  READ_8
+#		define READ_OPERAND_16 READ_16
+#	else
+#		undef BYTE_OPERAND
+#		undef WORD_OPERAND
+#		undef READ_BYTE_OPERAND
+#		undef READ_WORD_OPERAND
+#		define BYTE_OPERAND	 READ_8 (PC + 1)
+#		define WORD_OPERAND	 READ_16(PC + 1)
+#		define READ_BYTE_OPERAND READ_8 ((PC += 2) - 1)
+#		define READ_WORD_OPERAND READ_16((PC += 3) - 2)
+#	endif
+
+#endif
+
+
+#ifdef CPU_6502_WITH_REGISTER_CACHE
+
+#	undef REGISTERS
+#	undef CYCLES
+#	undef BUS_READ_8
+#	undef BUS_WRITE_8
+#	undef READ_16
+#	undef PUSH_16
+#	undef POP_16
+
+#	define REGISTERS object->state
+#	define CYCLES	 object->cycles
+
+#	ifdef CPU_6502_WITH_LAZY_FLAGS
+#		undef NZ
+#		define NZ object->lazy_nz
+#	endif
+
+#	ifdef CPU_6502_WITH_PAGE_TABLE
+#		define BUS_READ_8(address)	   read_8bit (object, (zuint16)(address))
+#		define BUS_WRITE_8(address, value) write_8bit(object, (zuint16)(address), (zuint8)(value))
+#	else
+#		define BUS_READ_8(address)	   READ_CALLBACK((zuint16)(address))
+#		define BUS_WRITE_8(address, value) object->write(object->context, (zuint16)(address), (zuint8)(value))
+#	endif
+
+#	define READ_16(address) read_16bit(object, (zuint16)(address))
+#	define PUSH_16(value)	push_16bit(object, value)
+#	define POP_16		pop_16bit(object)
+
+#	if defined(CPU_6502_WITH_DECODE_CACHE) || defined(CPU_6502_WITH_FETCH)
+#		undef READ_OPERAND_8
+#		undef READ_OPERAND_16
+#		define READ_OPERAND_8  READ_8
+#		define READ_OPERAND_16 READ_16
+#	endif
+
+#	ifdef CPU_6502_WITH_FETCH
+#		undef FETCH_CALLBACK
+#		define FETCH_CALLBACK(address) object->fetch(object->context, address)
+#	endif
+
+#endif
+
+
+#ifdef CPU_6502_WITH_DECODE_CACHE
+
+	CPU_6502_API void m6502_invalidate_code(M6502 *object, zuint8 page)
+		{if (object->decode_cache != NULL) invalidate_code(object->decode_cache, page);}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_LAZY_FLAGS
+
+	CPU_6502_API zuint8 m6502_flush_flags(M6502 *object)
+		{
+		P_FROM_NZ
+		return P;
+		}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_TRACE
+
+	CPU_6502_API void m6502_trace_flush(M6502 *object)
+		{switch_trace_buffer(object);}
+
+
+	CPU_6502_API zusize m6502_trace_decode(M6502TraceRecord *record, zuint8 const *data, zusize size)
+		{
+		zuint8 const *cursor = data + 2, *end = data + size;
+		zusize delta = 0, length;
+		zuint  shift = 0;
+		zuint8 flags, bit;
+		M6502TraceRecord decoded;
+
+		if (size < 3) return 0;
+
+		do	{
+			if (cursor == end || shift >= sizeof(zusize) * 8) return 0;
+			delta |= (zusize)(*cursor & 0x7F) << shift;
+			shift += 7;
+			}
+		while (*cursor++ & 0x80);
+
+		flags  = data[0];
+		length = (flags & 3 ? 0 : 2) + (flags & 128 ? 2 : 0);
+		for (bit = 4; bit < 128; bit <<= 1) if (flags & bit) length++;
+		if ((zusize)(end - cursor) < length) return 0;
+
+		decoded	       = *record;
+		decoded.cycle += delta;
+		decoded.opcode = data[1];
+
+		if (flags & 3) decoded.pc = (zuint16)(decoded.pc + (flags & 3));
+
+		else	{
+			decoded.pc = (zuint16)(cursor[0] | cursor[1] << 8);
+			cursor += 2;
+			}
+
+		if (flags &  4) decoded.a = *cursor++;
+		if (flags &  8) decoded.x = *cursor++;
+		if (flags & 16) decoded.y = *cursor++;
+		if (flags & 32) decoded.s = *cursor++;
+		if (flags & 64) decoded.p = *cursor++;
+
+		if ((decoded.has_ea = !!(flags & 128)))
+			{
+			decoded.ea = (zuint16)(cursor[0] | cursor[1] << 8);
+			cursor += 2;
+			}
+
+		*record = decoded;
+		return (zusize)(cursor - data);
+		}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_PROFILER
+
+	CPU_6502_API void m6502_profile_snapshot(M6502 const *object, M6502Profile *snapshot)
+		{
+		M6502Profile const *profile = object->profile;
+		zuint index;
+
+		for (index = 0; index < 256; index++)
+			{
+			snapshot->executions	    [index] = profile->executions	 [index];
+			snapshot->cycles	    [index] = profile->cycles		 [index];
+			snapshot->page_crossings    [index] = profile->page_crossings	 [index];
+			snapshot->branches_taken    [index] = profile->branches_taken	 [index];
+			snapshot->branches_not_taken[index] = profile->branches_not_taken[index];
+			}
+
+		for (index = 0; index < 65536; index++)
+			snapshot->pc_hits[index] = profile->pc_hits[index];
+		}
+
+
+	CPU_6502_API void m6502_profile_reset(M6502 *object)
+		{
+		M6502Profile *profile = object->profile;
+		zuint index;
+
+		for (index = 0; index < 256; index++)
+			{
+			profile->executions	    [index] =
+			profile->cycles		    [index] =
+			profile->page_crossings	    [index] =
+			profile->branches_taken	    [index] =
+			profile->branches_not_taken[index] = 0;
+			}
+
+		for (index = 0; index < 65536; index++) profile->pc_hits[index] = 0;
+		}
+
+
+	/*---------------------------------------------------------------.
+	| Each line of the export is "PPxx;PPAA N\n", where PP and AA    |
+	| are the page and the low byte of the address in hexadecimal    |
+	| and N is the number of hits in decimal. The characters are     |
+	| written only while they fit in the buffer, so that the size of |
+	| the whole text can be obtained by passing a size of 0.	 |
+	'---------------------------------------------------------------*/
+
+#	define EXPORT_CHARACTER(character) \
+		{if (length < size) buffer[length] = (character); length++;}
+
+#	define EXPORT_HEX_BYTE(value)					\
+		EXPORT_CHARACTER(hex_digits[((value) >> 4) & 0xF])	\
+		EXPORT_CHARACTER(hex_digits[ (value)	   & 0xF])
+
+
+	CPU_6502_API zusize m6502_profile_export(M6502Profile const *profile, char *buffer, zusize size)
+		{
+		static char const hex_digits[] = "0123456789ABCDEF";
+		zusize	length = 0;
+		zuint32 address, hits, divisor;
+
+		for (address = 0; address < 65536; address++)
+			if ((hits = profile->pc_hits[address]) != 0)
+				{
+				EXPORT_HEX_BYTE(address >> 8)
+				EXPORT_CHARACTER('x')
+				EXPORT_CHARACTER('x')
+				EXPORT_CHARACTER(';')
+				EXPORT_HEX_BYTE(address >> 8)
+				EXPORT_HEX_BYTE(address)
+				EXPORT_CHARACTER(' ')
+				for (divisor = 1; hits / divisor >= 10; divisor *= 10);
+
+				for (; divisor; divisor /= 10)
+					EXPORT_CHARACTER((char)('0' + hits / divisor % 10))
+
+				EXPORT_CHARACTER('\n')
+				}
+
+		return length;
+		}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_DECIMAL_TABLES
+
+	CPU_6502_API void m6502_build_decimal_tables(M6502DecimalTables *tables)
+		{
+		M6502 scratch;
+		M6502 *object = &scratch;
+		zuint carry, a, v;
+
+		/*-----------------------------------------------------------.
+		| The elements are computed by the same code that adc and    |
+		| sbc use when the emulator is built without the tables, so  |
+		| both builds produce the same results.			     |
+		'-----------------------------------------------------------*/
+		for (carry = 0; carry < 2; carry++)
+			for (a = 0; a < 256; a++)
+				for (v = 0; v < 256; v++)
+					{
+					zuint8 value = (zuint8)v, borrow = !carry;
+					zuint  t     = a - v - borrow;
+
+					A = (zuint8)a; P = 0;
+					COMPUTE_ADC_DECIMAL(value, carry)
+					P_FROM_NZ
+					tables->adc[carry][a][v] = (zuint16)(A | P << 8);
+
+					A = (zuint8)a; P = 0;
+					COMPUTE_SBC_DECIMAL(value, borrow, t)
+					P_FROM_NZ
+					tables->sbc[carry][a][v] = (zuint16)(A | P << 8);
+					}
+		}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_EVENTS
+
+	CPU_6502_API zboolean m6502_schedule(M6502 *object, zusize cycle, void (* callback)(void *context, zusize cycle))
+		{
+		M6502Event *events = object->events;
+		zusize index, parent;
+
+		if (object->event_count == object->event_capacity) return FALSE;
+
+		/*--------------------------------------------.
+		| Sift the new event up from the last leaf.   |
+		'--------------------------------------------*/
+		for (	index = object->event_count++;
+			index && events[parent = (index - 1) / 2].cycle > cycle;
+			index = parent
+		)
+			events[index] = events[parent];
+
+		events[index].cycle    = cycle;
+		events[index].callback = callback;
+		return TRUE;
+		}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_COPY_ON_WRITE
+
+	CPU_6502_API void m6502_fork(M6502 *object, M6502 *clone)
+		{
+		zuint index;
+
+		*clone = *object;
+
+#		ifdef CPU_6502_WITH_DECODE_CACHE
+			clone->decode_cache = NULL;
+#		endif
+
+		for (index = 0; index < 256; index++)
+			object->write_pages[index] = clone->write_pages[index] = NULL;
+		}
+
+#endif
+
+
+#ifdef CPU_6502_WITH_RECORD_REPLAY
+
+	/*-------------------------------------------------------------.
+	| During a replay, the interrupt lines are driven by the log.  |
+	'-------------------------------------------------------------*/
+
+	CPU_6502_API void m6502_nmi(M6502 *object)
+		{if (object->log_mode != M6502_LOG_MODE_REPLAY) NMI = PENDING = TRUE;}
+
+	CPU_6502_API void m6502_irq(M6502 *object, zboolean state)
+		{
+		if (object->log_mode != M6502_LOG_MODE_REPLAY)
+			{
+			IRQ = state;
+			PENDING = TRUE;
+			}
+		}
+
+#else
+	CPU_6502_API void m6502_nmi(M6502 *object)		   {NMI = PENDING = TRUE;}
+	CPU_6502_API void m6502_irq(M6502 *object, zboolean state) {IRQ = state; PENDING = TRUE;}
+#endif
+
+
+/* MARK: - Snapshots
+.-----------------------------------------------------------.
+| Offset | Size | Content                                   |
+|--------+------+-------------------------------------------|
+|      0 |    1 | Format version                            |
+|      1 |    2 | PC                                        |
+|      3 |    1 | S                                         |
+|      4 |    1 | P                                         |
+|      5 |    1 | A                                         |
+|      6 |    1 | X                                         |
+|      7 |    1 | Y                                         |
+|      8 |    1 | Bit 0 = NMI; 1 = IRQ; 2 = jam;            |
+|        |      | 3-4 = interrupt_poll (cycle-exact mode)   |
+|      9 |    1 | opcode                                    |
+|     10 |    1 | ea_cycles                                 |
+|     11 |    2 | ea                                        |
+|     13 |    8 | cycles                                    |
+|-----------------------------------------------------------|
+| Multibyte values are stored in little-endian.             |
+'-----------------------------------------------------------*/
+
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_SIZE	 21
+
+
+CPU_6502_API zusize m6502_snapshot_size(void) {return SNAPSHOT_SIZE;}
+
+
+CPU_6502_API void m6502_save(M6502 const *object, zuint8 *snapshot)
+	{
+	zusize cycles = CYCLES;
+	zuint index;
+
+	snapshot[ 0] = SNAPSHOT_VERSION;
+	snapshot[ 1] = (zuint8)PC;
+	snapshot[ 2] = (zuint8)(PC >> 8);
+	snapshot[ 3] = S;
+	snapshot[ 4] = P;
+	snapshot[ 5] = A;
+	snapshot[ 6] = X;
+	snapshot[ 7] = Y;
+	snapshot[ 8] = (zuint8)((NMI ? 1 : 0) | (IRQ ? 2 : 0) | (JAMMED ? 4 : 0));
+	snapshot[ 9] = OPCODE;
+	snapshot[10] = EA_CYCLES;
+	snapshot[11] = (zuint8)EA;
+	snapshot[12] = (zuint8)(EA >> 8);
+
+	/*-----------------------------------------------------------.
+	| The interrupt sampled during the last instruction is taken |
+	| at the next instruction boundary, which may be in the next |
+	| call to m6502_run.					     |
+	'-----------------------------------------------------------*/
+#	ifdef CPU_6502_WITH_CYCLE_EXACT
+		snapshot[8] |= (zuint8)(object->interrupt_poll << 3);
+#	endif
+
+	for (index = 13; index < SNAPSHOT_SIZE; index++, cycles >>= 8)
+		snapshot[index] = (zuint8)cycles;
+	}
+
+
+CPU_6502_API zboolean m6502_load(M6502 *object, zuint8 const *snapshot)
+	{
+	zusize cycles = 0;
+	zuint index = SNAPSHOT_SIZE;
+
+	if (snapshot[0] != SNAPSHOT_VERSION) return FALSE;
+
+	PC	  = (zuint16)(snapshot[1] | snapshot[2] << 8);
+	S	  = snapshot[3];
+	P	  = snapshot[4];
+	A	  = snapshot[5];
+	X	  = snapshot[6];
+	Y	  = snapshot[7];
+	NMI	  = snapshot[8] & 1;
+	IRQ	  = snapshot[8] >> 1 & 1;
+	OPCODE	  = snapshot[9];
+	EA_CYCLES = snapshot[10];
+	EA	  = (zuint16)(snapshot[11] | snapshot[12] << 8);
+
+#	ifdef CPU_6502_WITH_UNDOCUMENTED_OPCODES
+		JAMMED = snapshot[8] >> 2 & 1;
+#	endif
+
+#	ifdef CPU_6502_WITH_CYCLE_EXACT
+		object->interrupt_poll = snapshot[8] >> 3 & 3;
+#	endif
+
+	while (index-- > 13) cycles = cycles << 8 | snapshot[index];
+	CYCLES = cycles;
+	return TRUE;
+	}
 
 
 /* MARK: - ABI */
@@ -0,0 +1,507 @@
+/* vim: set tabstop=8 noexpandtab: */
+/*      ____ ______ ______  ____
+       /  _//\  __//\  __ \/\_, \
+ ____ /\  __ \\___  \\ \/\ \//  /__ ___________________________________________
+|     \ \_____\\____/ \_____\\_____\                                           |
+|  MOS \/_____//___/ \/_____//_____/ CPU Emulator - Benchmark                   |
+|  Copyright (C) 1999-2025 Manuel Sainz de Baranda y Goñi.                     |
+|                                                                              |
+|  This program is free software: you can redistribute it and/or modify it     |
+|  under the terms of the GNU Lesser General Public License as published by    |
+|  the Free Software Foundation, either version 3 of the License, or (at your  |
+|  option) any later version.                                                  |
+|                                                                              |
+|  This program is distributed in the hope that it will be useful, but         |
+|  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY  |
+|  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public      |
+|  License for more details.                                                   |
+|                                                                              |
+|  You should have received a copy of the GNU Lesser General Public License    |
+|  along with this program. If not, see <http://www.gnu.org/licenses/>.        |
+|                                                                              |
+'=============================================================================*/
+
+/*----------------------------------------------------------------------------.
+| Runs a set of fixed workloads through m6502_run and prints, for each one,   |
+| the emulated frequency, the host time per instruction and the number of     |
+| calls to the memory callbacks as JSON. The program must be built with the   |
+| same configuration macros as the emulator.				      |
+|									      |
+| Usage: benchmark-6502 [-c <cycles>] [<6502_functional_test.bin>]	      |
+|									      |
+| The optional binary is Klaus Dormann's 6502 functional test, assembled to   |
+| be loaded at 0000h and started at 0400h. It runs until it traps (jumps to   |
+| itself) and it is reported as passed if it traps at 3469h.		      |
+|									      |
+| The cost of checking the interrupt lines before every instruction, which    |
+| m6502_run avoids while no interrupt can be accepted, is measured by	      |
+| building the program and the emulator once more with			      |
+| CPU_6502_WITH_EAGER_INTERRUPT_CHECK and comparing the "implied" workload.   |
+|									      |
+| Each workload is also run one instruction at a time, once with m6502_step   |
+| and once with m6502_run(object, 1), and the host time per instruction of    |
+| both ways is reported as well, so that the cost of the single-pass copy of  |
+| the loop used by m6502_step can be compared with that of a whole call to    |
+| m6502_run. The functional test is run in the same three ways.	      |
+'----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef CPU_6502_DEPENDENCIES_H
+#	include CPU_6502_DEPENDENCIES_H
+#else
+#	include <Z/hardware/CPU/architecture/6502.h>
+#endif
+
+#ifdef CPU_6502_USE_LOCAL_HEADER
+#	include "6502.h"
+#else
+#	include <emulation/CPU/6502.h>
+#endif
+
+#define DEFAULT_CYCLES		     200000000
+#define IO_ACKNOWLEDGE_IRQ	     0xD000
+#define FUNCTIONAL_TEST_START	     0x0400
+#define FUNCTIONAL_TEST_SUCCESS	     0x3469
+#define FUNCTIONAL_TEST_MAXIMUM_CYCLES 200000000
+#define FUNCTIONAL_TEST_RUN_CYCLES     100000
+
+#define PASS_STEP		     0
+#define PASS_RUN_1		     1
+#define PASS_RUN		     2
+
+
+typedef struct {
+	M6502	     cpu;
+	zuint8	     memory[65536];
+	zusize	     reads;
+	zusize	     writes;
+	zusize	     slices;
+	zusize	     irqs;
+} Machine;
+
+
+typedef struct {
+	char const*  name;
+	zuint8 const *program;
+	zusize	     program_size;
+	zusize	     slice;
+	void	     (* tick)(Machine *machine);
+} Workload;
+
+
+static zuint8 machine_read(void *context, zuint16 address)
+	{
+	Machine *machine = (Machine *)context;
+
+	machine->reads++;
+	return machine->memory[address];
+	}
+
+
+static void machine_write(void *context, zuint16 address, zuint8 value)
+	{
+	Machine *machine = (Machine *)context;
+
+	machine->writes++;
+	machine->memory[address] = value;
+
+	if (address == IO_ACKNOWLEDGE_IRQ)
+		{
+		machine->irqs++;
+		m6502_irq(&machine->cpu, FALSE);
+		}
+	}
+
+
+/* MARK: - Workloads */
+
+/*-----------------------------------------------------------------.
+| adc and sbc in decimal mode over 16 BCD accumulators.		   |
+|								   |
+| 0200 sed        0203 txa        0209 sec        020F cpx #10h	   |
+| 0201 ldx #0     0204 clc        020A sbc 30h,x  0211 bne 0203	   |
+|                 0205 adc 10h,x  020C sta 30h,x  0213 jmp 0201	   |
+|                 0207 sta 10h,x  020E inx			   |
+'-----------------------------------------------------------------*/
+
+static zuint8 const decimal_program[] = {
+	0xF8, 0xA2, 0x00, 0x8A, 0x18, 0x75, 0x10, 0x95, 0x10, 0x38, 0xF5, 0x30,
+	0x95, 0x30, 0xE8, 0xE0, 0x10, 0xD0, 0xF0, 0x4C, 0x01, 0x02
+};
+
+/*----------------------------------------------------------------.
+| Conditional branches depending on the bits of a counter.	  |
+|								  |
+| 0200 ldx #0    0207 beq 020B   020E bne 0211   0216 bmi 0218	  |
+| 0202 ldy #0    0209 iny        0210 dey        0218 inx	  |
+| 0204 txa       020A iny        0211 cpy #80h   0219 bne 0204	  |
+| 0205 and #1    020B txa        0213 bcc 0216   021B jmp 0200	  |
+|                020C and #2     0215 nop			  |
+'----------------------------------------------------------------*/
+
+static zuint8 const branch_program[] = {
+	0xA2, 0x00, 0xA0, 0x00, 0x8A, 0x29, 0x01, 0xF0, 0x02, 0xC8, 0xC8, 0x8A,
+	0x29, 0x02, 0xD0, 0x01, 0x88, 0xC0, 0x80, 0x90, 0x01, 0xEA, 0x30, 0x00,
+	0xE8, 0xD0, 0xE9, 0x4C, 0x00, 0x02
+};
+
+/*-------------------------------------------------------------------.
+| Copy of 4000h-7FFFh to 8000h-BFFFh through (indirect),Y pointers.  |
+|								     |
+| 0200 lda #0     0208 sta FCh     0210 lda (FBh),y  0219 inc FEh    |
+| 0202 sta FBh    020A lda #80h    0212 sta (FDh),y  021B lda FCh    |
+| 0204 sta FDh    020C sta FEh     0214 iny          021D cmp #80h   |
+| 0206 lda #40h   020E ldy #0      0215 bne 0210     021F bne 0210   |
+|                                  0217 inc FCh      0221 jmp 0200   |
+'-------------------------------------------------------------------*/
+
+static zuint8 const memory_walk_program[] = {
+	0xA9, 0x00, 0x85, 0xFB, 0x85, 0xFD, 0xA9, 0x40, 0x85, 0xFC, 0xA9, 0x80,
+	0x85, 0xFE, 0xA0, 0x00, 0xB1, 0xFB, 0x91, 0xFD, 0xC8, 0xD0, 0xF9, 0xE6,
+	0xFC, 0xE6, 0xFE, 0xA5, 0xFC, 0xC9, 0x80, 0xD0, 0xEF, 0x4C, 0x00, 0x02
+};
+
+/*--------------------------------------------------------------.
+| Implied mode instructions with no interrupts, so that most of |
+| the time is spent in the interpreter loop itself.		|
+|								|
+| 0200 inx   0203 tay   0206 tya   0209 sec   020C jmp 0200	|
+| 0201 iny   0204 dex   0207 tax   020A nop			|
+| 0202 txa   0205 dey   0208 clc   020B inx			|
+'--------------------------------------------------------------*/
+
+static zuint8 const implied_program[] = {
+	0xE8, 0xC8, 0x8A, 0xA8, 0xCA, 0x88, 0x98, 0xAA, 0x18, 0x38, 0xEA, 0xE8,
+	0x4C, 0x00, 0x02
+};
+
+/*-------------------------------------------------------------------.
+| A busy loop interrupted by an IRQ every 100 cycles and a NMI every |
+| 1000 cycles. The IRQ handler acknowledges it by writing to D000h.  |
+|								     |
+| 0200 cli           0300 pha          0306 pla      0310 inc 21h    |
+| 0201 inx           0301 inc 20h      0307 rti      0312 rti	     |
+| 0202 jmp 0201      0303 sta D000h				     |
+'-------------------------------------------------------------------*/
+
+static zuint8 const interrupt_storm_program[] = {
+	0x58, 0xE8, 0x4C, 0x01, 0x02
+};
+
+static zuint8 const interrupt_storm_handlers[] = {
+	0x48, 0xE6, 0x20, 0x8D, 0x00, 0xD0, 0x68, 0x40, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xE6, 0x21, 0x40
+};
+
+
+static void interrupt_storm_tick(Machine *machine)
+	{
+	m6502_irq(&machine->cpu, TRUE);
+	if (!(machine->slices % 10)) m6502_nmi(&machine->cpu);
+	}
+
+
+static Workload const workloads[] = {
+	{"decimal",	    decimal_program,	     sizeof(decimal_program),	      0,   NULL},
+	{"branch",	    branch_program,	     sizeof(branch_program),	      0,   NULL},
+	{"memory_walk",	    memory_walk_program,     sizeof(memory_walk_program),     0,   NULL},
+	{"implied",	    implied_program,	     sizeof(implied_program),	      0,   NULL},
+	{"interrupt_storm", interrupt_storm_program, sizeof(interrupt_storm_program), 100, interrupt_storm_tick}
+};
+
+
+/* MARK: - Machine */
+
+static void machine_initialize(Machine *machine)
+	{
+	memset(machine, 0, sizeof(Machine));
+	machine->cpu.context = machine;
+	machine->cpu.read    = machine_read;
+	machine->cpu.write   = machine_write;
+
+#	ifdef CPU_6502_WITH_PAGE_TABLE
+		{
+		zuint page;
+
+		for (page = 0; page < 256; page++) if (page != IO_ACKNOWLEDGE_IRQ >> 8)
+			{
+			machine->cpu.read_pages [page] = machine->memory + page * 256;
+			machine->cpu.write_pages[page] = machine->memory + page * 256;
+			}
+		}
+#	endif
+
+	m6502_power(&machine->cpu, TRUE);
+	}
+
+
+/*--------------------------------------------------------------.
+| Assigns the decode cache and the decimal tables, if they are	|
+| enabled, to the CPU. It must be called after initializing the |
+| machine, since that clears them. The decode cache is cleared. |
+'--------------------------------------------------------------*/
+
+static void machine_attach(Machine *machine, void *decode_cache, void *decimal_tables)
+	{
+	(void)machine;
+	(void)decode_cache;
+	(void)decimal_tables;
+
+#	ifdef CPU_6502_WITH_DECODE_CACHE
+		memset(decode_cache, 0, sizeof(M6502DecodeCache));
+		machine->cpu.decode_cache = decode_cache;
+#	endif
+
+#	ifdef CPU_6502_WITH_DECIMAL_TABLES
+		machine->cpu.decimal_tables = decimal_tables;
+#	endif
+	}
+
+
+static void machine_load_workload(Machine *machine, Workload const *workload)
+	{
+	zuint index;
+
+	machine_initialize(machine);
+
+	for (index = 0; index < 65536; index++)
+		machine->memory[index] = (zuint8)(index * 7 + (index >> 8));
+
+	memcpy(machine->memory + 0x0200, workload->program, workload->program_size);
+	memcpy(machine->memory + 0x0300, interrupt_storm_handlers, sizeof(interrupt_storm_handlers));
+	machine->memory[0xFFFA] = 0x10; machine->memory[0xFFFB] = 0x03;
+	machine->memory[0xFFFC] = 0x00; machine->memory[0xFFFD] = 0x02;
+	machine->memory[0xFFFE] = 0x00; machine->memory[0xFFFF] = 0x03;
+	m6502_reset(&machine->cpu);
+	}
+
+
+/*-------------------------------------------------------------------.
+| Executes at least `cycles` cycles in slices, either with m6502_run |
+| or one instruction at a time, in which case the instructions are   |
+| counted in `steps`. Every pass runs through the same instructions. |
+'-------------------------------------------------------------------*/
+
+static zusize machine_run(Machine *machine, Workload const *workload, zusize cycles, zuint pass, zusize *steps)
+	{
+	zusize slice = workload->slice ? workload->slice : cycles;
+	zusize total = 0, executed;
+
+	while (total < cycles)
+		{
+		if (workload->tick != NULL) workload->tick(machine);
+		machine->slices++;
+
+		if (pass == PASS_RUN) executed = m6502_run(&machine->cpu, slice);
+
+		else if (pass == PASS_STEP) for (executed = 0; executed < slice; (*steps)++)
+			executed += m6502_step(&machine->cpu);
+
+		else for (executed = 0; executed < slice; (*steps)++)
+			executed += m6502_run(&machine->cpu, 1);
+
+		total += executed;
+		}
+
+	return total;
+	}
+
+
+/* MARK: - Report */
+
+static void print_result(char const *name, zusize cycles, zusize instructions, double seconds, Machine *machine, char const *extra, zboolean last)
+	{
+	printf(	"\t\t{\"name\": \"%s\", \"cycles\": %lu, \"instructions\": %lu, "
+		"\"seconds\": %.6f, \"emulated_mhz\": %.3f, \"ns_per_instruction\": %.3f, "
+		"\"reads\": %lu, \"writes\": %lu, \"irq_acknowledges\": %lu%s}%s\n",
+		name,
+		(unsigned long)cycles,
+		(unsigned long)instructions,
+		seconds,
+		seconds > 0.0 ? (double)cycles / seconds / 1000000.0 : 0.0,
+		instructions ? seconds * 1000000000.0 / (double)instructions : 0.0,
+		(unsigned long)machine->reads,
+		(unsigned long)machine->writes,
+		(unsigned long)machine->irqs,
+		extra,
+		last ? "" : ",");
+	}
+
+
+/*-----------------------------------------------------------------.
+| Runs the functional test until it traps. The pass that uses	   |
+| m6502_run executes it in long runs and looks for the trap with a |
+| single instruction after each one, so it overshoots the trap by  |
+| less than FUNCTIONAL_TEST_RUN_CYCLES cycles. The instructions	   |
+| are only counted exactly by the other passes.			   |
+'-----------------------------------------------------------------*/
+
+static double functional_test_pass(Machine *machine, zuint8 const *image, void *decode_cache, void *decimal_tables, zuint pass, zusize *cycles, zusize *instructions, zuint16 *pc)
+	{
+	clock_t start;
+
+	machine_initialize(machine);
+	machine_attach(machine, decode_cache, decimal_tables);
+	memcpy(machine->memory, image, 65536);
+	machine->cpu.state.pc = FUNCTIONAL_TEST_START;
+	*cycles = *instructions = 0;
+	start = clock();
+
+	do	{
+		if (pass == PASS_RUN)
+			*cycles += m6502_run(&machine->cpu, FUNCTIONAL_TEST_RUN_CYCLES);
+
+		*pc = machine->cpu.state.pc;
+
+		*cycles += pass == PASS_RUN_1
+			? m6502_run(&machine->cpu, 1)
+			: m6502_step(&machine->cpu);
+
+		(*instructions)++;
+		}
+	while (machine->cpu.state.pc != *pc && *cycles < FUNCTIONAL_TEST_MAXIMUM_CYCLES);
+
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+	}
+
+
+static zboolean run_functional_test(Machine *machine, char const *path, void *decode_cache, void *decimal_tables, zboolean last)
+	{
+	FILE*	file = fopen(path, "rb");
+	zuint8* image;
+	zusize	cycles, instructions, steps, size;
+	zuint16 pc;
+	double	seconds[3];
+	char	extra[128];
+	zuint	pass;
+
+	if (file == NULL)
+		{
+		fprintf(stderr, "benchmark-6502: cannot open \"%s\"\n", path);
+		return FALSE;
+		}
+
+	if ((image = calloc(65536, 1)) == NULL)
+		{
+		fclose(file);
+		return FALSE;
+		}
+
+	size = fread(image, 1, 65536, file);
+	fclose(file);
+
+	if (!size)
+		{
+		fprintf(stderr, "benchmark-6502: cannot read \"%s\"\n", path);
+		free(image);
+		return FALSE;
+		}
+
+	for (steps = pass = 0; pass < 3; pass++)
+		{
+		seconds[pass] = functional_test_pass(
+			machine, image, decode_cache, decimal_tables, pass,
+			&cycles, &instructions, &pc);
+
+		if (pass == PASS_STEP) steps = instructions;
+		}
+
+	free(image);
+
+	sprintf(extra,
+		", \"step_ns_per_instruction\": %.3f, \"run_1_ns_per_instruction\": %.3f, \"passed\": %s",
+		steps ? seconds[PASS_STEP]  * 1000000000.0 / (double)steps : 0.0,
+		steps ? seconds[PASS_RUN_1] * 1000000000.0 / (double)steps : 0.0,
+		pc == FUNCTIONAL_TEST_SUCCESS ? "true" : "false");
+
+	print_result("functional_test", cycles, steps, seconds[PASS_RUN], machine, extra, last);
+	return TRUE;
+	}
+
+
+/* MARK: - Main */
+
+int main(int argc, char **argv)
+	{
+	Machine* machine;
+	zusize	 cycles = DEFAULT_CYCLES, executed, instructions, steps;
+	char*	 functional_test = NULL;
+	int	 index;
+	zuint	 workload_index, workload_count = sizeof(workloads) / sizeof(Workload), pass;
+	clock_t	 start;
+	double	 seconds[3];
+	char	 extra[128];
+	void*	 decode_cache	 = NULL;
+	void*	 decimal_tables	 = NULL;
+
+	for (index = 1; index < argc; index++)
+		{
+		if (!strcmp(argv[index], "-c") && index + 1 < argc)
+			cycles = (zusize)strtoul(argv[++index], NULL, 10);
+
+		else if (argv[index][0] != '-' && functional_test == NULL)
+			functional_test = argv[index];
+
+		else	{
+			fprintf(stderr, "Usage: benchmark-6502 [-c <cycles>] [<6502_functional_test.bin>]\n");
+			return -1;
+			}
+		}
+
+	if ((machine = malloc(sizeof(Machine))) == NULL) return -1;
+
+#	ifdef CPU_6502_WITH_DECODE_CACHE
+		if ((decode_cache = malloc(sizeof(M6502DecodeCache))) == NULL) return -1;
+#	endif
+
+#	ifdef CPU_6502_WITH_DECIMAL_TABLES
+		if ((decimal_tables = malloc(sizeof(M6502DecimalTables))) == NULL) return -1;
+		m6502_build_decimal_tables(decimal_tables);
+#	endif
+
+	printf("{\n\t\"cycles\": %lu,\n\t\"workloads\": [\n", (unsigned long)cycles);
+
+	for (workload_index = 0; workload_index < workload_count; workload_index++)
+		{
+		Workload const *workload = &workloads[workload_index];
+
+		/*--------------------------------------------------------.
+		| The machine is reset before each pass so that all of	  |
+		| them run exactly the same code. The pass that uses	  |
+		| m6502_run goes last, so the counters of the machine are |
+		| reported for it.					  |
+		'--------------------------------------------------------*/
+		for (instructions = pass = 0; pass < 3; pass++)
+			{
+			steps = 0;
+			machine_load_workload(machine, workload);
+			machine_attach(machine, decode_cache, decimal_tables);
+
+			start	      = clock();
+			executed      = machine_run(machine, workload, cycles, pass, &steps);
+			seconds[pass] = (double)(clock() - start) / CLOCKS_PER_SEC;
+			if (pass == PASS_STEP) instructions = steps;
+			}
+
+		sprintf(extra,
+			", \"step_ns_per_instruction\": %.3f, \"run_1_ns_per_instruction\": %.3f",
+			instructions ? seconds[PASS_STEP]  * 1000000000.0 / (double)instructions : 0.0,
+			instructions ? seconds[PASS_RUN_1] * 1000000000.0 / (double)instructions : 0.0);
+
+		print_result(
+			workload->name, executed, instructions, seconds[PASS_RUN], machine, extra,
+			functional_test == NULL && workload_index + 1 == workload_count);
+		}
+
+	if (functional_test != NULL && !run_functional_test(machine, functional_test, decode_cache, decimal_tables, TRUE))
+		printf("\t\t{\"name\": \"functional_test\", \"error\": true}\n");
+
+	printf("\t]\n}\n");
+	return 0;
+	}
+
+/* benchmark-6502.c EOF */
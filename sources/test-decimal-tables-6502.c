@@ -0,0 +1,213 @@
+/* vim: set tabstop=8 noexpandtab: */
+/*      ____ ______ ______  ____
+       /  _//\  __//\  __ \/\_, \
+ ____ /\  __ \\___  \\ \/\ \//  /__ ___________________________________________
+|     \ \_____\\____/ \_____\\_____\                                           |
+|  MOS \/_____//___/ \/_____//_____/ CPU Emulator - Decimal Tables Test        |
+|  Copyright (C) 1999-2025 Manuel Sainz de Baranda y Goñi.                     |
+|                                                                              |
+|  This program is free software: you can redistribute it and/or modify it     |
+|  under the terms of the GNU Lesser General Public License as published by    |
+|  the Free Software Foundation, either version 3 of the License, or (at your  |
+|  option) any later version.                                                  |
+|                                                                              |
+|  This program is distributed in the hope that it will be useful, but         |
+|  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY  |
+|  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public      |
+|  License for more details.                                                   |
+|                                                                              |
+|  You should have received a copy of the GNU Lesser General Public License    |
+|  along with this program. If not, see <http://www.gnu.org/licenses/>.        |
+|                                                                              |
+'=============================================================================*/
+
+/*----------------------------------------------------------------------------.
+| Checks the tables built by m6502_build_decimal_tables against the code that |
+| computes the decimal mode of adc and sbc when the emulator is built without |
+| them, for every combination of the C flag, the accumulator and the operand. |
+| Each combination is also executed as `adc #n` and `sbc #n` with the D flag  |
+| set, and the resulting A, P and cycles are compared with those of the same  |
+| instruction without the tables. The program must be built with the same    |
+| configuration macros as the emulator, which must include		      |
+| CPU_6502_WITH_DECIMAL_TABLES, so each CPU variant needs its own build.      |
+|									      |
+| It exits with status 0 if all the results match, or prints the first	      |
+| mismatch and exits with status 1.					      |
+'----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CPU_6502_DEPENDENCIES_H
+#	include CPU_6502_DEPENDENCIES_H
+#else
+#	include <Z/hardware/CPU/architecture/6502.h>
+#endif
+
+#ifdef CPU_6502_USE_LOCAL_HEADER
+#	include "6502.h"
+#	include "6502-semantics.h"
+#else
+#	include <emulation/CPU/6502.h>
+#	include <emulation/CPU/6502-semantics.h>
+#endif
+
+#ifndef CPU_6502_WITH_DECIMAL_TABLES
+#	error "This program requires CPU_6502_WITH_DECIMAL_TABLES."
+#endif
+
+/*-------------------------------------------------------------.
+| The reference results are computed by the ADC and SBC macros |
+| of the shared semantics with the table lookup replaced by    |
+| the nibble arithmetic, as in the build without the tables.   |
+'-------------------------------------------------------------*/
+
+#undef ADC_DECIMAL
+#undef SBC_DECIMAL
+#undef EXTRA_CYCLE
+
+#define ADC_DECIMAL COMPUTE_ADC_DECIMAL
+#define SBC_DECIMAL COMPUTE_SBC_DECIMAL
+#define EXTRA_CYCLE CYCLES++;
+
+#define PROGRAM_ADDRESS 0x0200
+
+
+typedef struct {
+	char const* name;
+	zuint8	    opcode;
+	zuint16	    (* table)[256][256];
+} Operation;
+
+
+static zuint8 memory[65536];
+
+
+static zuint8 test_read(void *context, zuint16 address)
+	{
+	(void)context;
+	return memory[address];
+	}
+
+
+static void test_write(void *context, zuint16 address, zuint8 value)
+	{
+	(void)context;
+	memory[address] = value;
+	}
+
+
+static zuint16 table_reference(zuint8 opcode, zuint8 carry, zuint8 a, zuint8 value)
+	{
+	M6502 scratch;
+	M6502 *object = &scratch;
+	zuint8 borrow = !carry;
+	zuint  t      = a - value - borrow;
+
+	A = a; P = 0;
+	NZ_FROM_P
+
+	if (opcode == 0x69) {COMPUTE_ADC_DECIMAL(value, carry)}
+	else {COMPUTE_SBC_DECIMAL(value, borrow, t)}
+
+	P_FROM_NZ
+	return (zuint16)(A | P << 8);
+	}
+
+
+static void instruction_reference(M6502 *object, zuint8 opcode, zuint8 value)
+	{
+	CYCLES = 2;
+	NZ_FROM_P
+
+	if (opcode == 0x69) ADC(value)
+	else SBC(value)
+
+	P_FROM_NZ
+	PC = PROGRAM_ADDRESS + 2;
+	}
+
+
+int main(void)
+	{
+	M6502DecimalTables *tables = malloc(sizeof(M6502DecimalTables));
+	M6502		   cpu, expected;
+	Operation	   operations[2];
+	zuint		   operation_index, carry, a, value;
+	zusize		   cycles;
+	zuint16		   element, reference;
+
+	if (tables == NULL) return 1;
+	m6502_build_decimal_tables(tables);
+
+	operations[0].name   = "adc";
+	operations[0].opcode = 0x69;
+	operations[0].table  = tables->adc;
+	operations[1].name   = "sbc";
+	operations[1].opcode = 0xE9;
+	operations[1].table  = tables->sbc;
+
+	for (operation_index = 0; operation_index < 2; operation_index++)
+		{
+		Operation const *operation = &operations[operation_index];
+
+		for (carry = 0; carry < 2; carry++)
+			for (a = 0; a < 256; a++)
+				for (value = 0; value < 256; value++)
+					{
+					/*----------------------------------------------.
+					| The element of the table must be the result	|
+					| of the code used to build it.			|
+					'----------------------------------------------*/
+					element	  = operation->table[carry][a][value];
+					reference = table_reference(operation->opcode, (zuint8)carry, (zuint8)a, (zuint8)value);
+
+					if (element != reference)
+						{
+						printf(	"%s table [C=%u][A=%02X][%02X]: %04X, expected %04X\n",
+							operation->name, carry, a, value, element, reference);
+
+						return 1;
+						}
+
+					/*-----------------------------------------------.
+					| The instruction executed with the tables must	 |
+					| behave as it does without them.		 |
+					'-----------------------------------------------*/
+					memset(&cpu, 0, sizeof(M6502));
+					cpu.read	   = test_read;
+					cpu.write	   = test_write;
+					cpu.decimal_tables = tables;
+					cpu.state.pc	   = PROGRAM_ADDRESS;
+					cpu.state.a	   = (zuint8)a;
+					cpu.state.p	   = (zuint8)(DP | IP | carry);
+					memory[PROGRAM_ADDRESS]	    = operation->opcode;
+					memory[PROGRAM_ADDRESS + 1] = (zuint8)value;
+					expected = cpu;
+					instruction_reference(&expected, operation->opcode, (zuint8)value);
+					cycles = m6502_run(&cpu, 1);
+
+					if (	cycles	     != expected.cycles	  ||
+						cpu.state.pc != expected.state.pc ||
+						cpu.state.a  != expected.state.a  ||
+						cpu.state.p  != expected.state.p
+					)
+						{
+						printf(	"%s #%02X with C=%u A=%02X: A=%02X P=%02X %lu cycles, "
+							"expected A=%02X P=%02X %lu cycles\n",
+							operation->name, value, carry, a,
+							cpu.state.a, cpu.state.p, (unsigned long)cycles,
+							expected.state.a, expected.state.p, (unsigned long)expected.cycles);
+
+						return 1;
+						}
+					}
+		}
+
+	printf("All %u combinations of adc and sbc match.\n", 2 * 2 * 256 * 256);
+	free(tables);
+	return 0;
+	}
+
+/* test-decimal-tables-6502.c EOF */
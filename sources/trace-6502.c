@@ -0,0 +1,185 @@
+/* vim: set tabstop=8 noexpandtab: */
+/*      ____ ______ ______  ____
+       /  _//\  __//\  __ \/\_, \
+ ____ /\  __ \\___  \\ \/\ \//  /__ ___________________________________________
+|     \ \_____\\____/ \_____\\_____\                                           |
+|  MOS \/_____//___/ \/_____//_____/ CPU Emulator - Trace Reader               |
+|  Copyright (C) 1999-2025 Manuel Sainz de Baranda y Goñi.                     |
+|                                                                              |
+|  This program is free software: you can redistribute it and/or modify it     |
+|  under the terms of the GNU Lesser General Public License as published by    |
+|  the Free Software Foundation, either version 3 of the License, or (at your  |
+|  option) any later version.                                                  |
+|                                                                              |
+|  This program is distributed in the hope that it will be useful, but         |
+|  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY  |
+|  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public      |
+|  License for more details.                                                   |
+|                                                                              |
+|  You should have received a copy of the GNU Lesser General Public License    |
+|  along with this program. If not, see <http://www.gnu.org/licenses/>.        |
+|                                                                              |
+'=============================================================================*/
+
+/*----------------------------------------------------------------------------.
+| Decodes an execution trace written by m6502_run and prints one line of text |
+| per instruction, optionally only those whose address is within a range.     |
+|									      |
+| Usage: trace-6502 [-r <first>-<last>] [<trace file>]			      |
+|									      |
+| The addresses of the range are hexadecimal. The trace is read from the      |
+| standard input if no file is given. The file is the sequence of buffers     |
+| passed to the `flush` callback of M6502Trace, each one preceded by its      |
+| size as a 32-bit little-endian integer. The program exits with status 1 if  |
+| a buffer is truncated or contains an incomplete record.		      |
+'----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CPU_6502_DEPENDENCIES_H
+#	include CPU_6502_DEPENDENCIES_H
+#else
+#	include <Z/hardware/CPU/architecture/6502.h>
+#endif
+
+#ifdef CPU_6502_USE_LOCAL_HEADER
+#	include "6502.h"
+#else
+#	include <emulation/CPU/6502.h>
+#endif
+
+#ifndef CPU_6502_WITH_TRACE
+#	error "This program requires CPU_6502_WITH_TRACE."
+#endif
+
+
+static void print_usage(void)
+	{fputs("Usage: trace-6502 [-r <first>-<last>] [<trace file>]\n", stderr);}
+
+
+static zboolean parse_range(char const *text, zuint16 *first, zuint16 *last)
+	{
+	char	      *end;
+	unsigned long value = strtoul(text, &end, 16);
+
+	if (end == text || *end != '-' || value > 0xFFFF) return FALSE;
+	*first = (zuint16)value;
+	text   = end + 1;
+	value  = strtoul(text, &end, 16);
+	if (end == text || *end || value > 0xFFFF || value < *first) return FALSE;
+	*last = (zuint16)value;
+	return TRUE;
+	}
+
+
+static void print_record(M6502TraceRecord const *record)
+	{
+	printf(	"%10lu %04X %02X A=%02X X=%02X Y=%02X S=%02X P=%02X",
+		(unsigned long)record->cycle, record->pc, record->opcode,
+		record->a, record->x, record->y, record->s, record->p);
+
+	if (record->has_ea) printf(" EA=%04X", record->ea);
+	putchar('\n');
+	}
+
+
+int main(int argc, char **argv)
+	{
+	FILE*		 file	     = stdin;
+	char const*	 path	     = "<stdin>";
+	zuint8*		 buffer	     = NULL;
+	zusize		 buffer_size = 0;
+	zuint16		 first	     = 0x0000;
+	zuint16		 last	     = 0xFFFF;
+	zuint8		 header[4];
+	zusize		 size, offset, record_size, header_size;
+	M6502TraceRecord record;
+	int		 index;
+
+	for (index = 1; index < argc && argv[index][0] == '-' && argv[index][1]; index++)
+		{
+		if (!strcmp(argv[index], "-r") && index + 1 < argc)
+			{
+			if (!parse_range(argv[++index], &first, &last))
+				{
+				fprintf(stderr, "Invalid range: %s\n", argv[index]);
+				return 1;
+				}
+			}
+
+		else	{
+			print_usage();
+			return 1;
+			}
+		}
+
+	if (index + 1 < argc)
+		{
+		print_usage();
+		return 1;
+		}
+
+	if (index < argc && (file = fopen(path = argv[index], "rb")) == NULL)
+		{
+		fprintf(stderr, "Cannot open %s\n", path);
+		return 1;
+		}
+
+	/*----------------------------------------------------.
+	| Each buffer starts a new sequence of deltas, so the |
+	| previous record is cleared before decoding it.      |
+	'----------------------------------------------------*/
+	while ((header_size = fread(header, 1, 4, file)) != 0)
+		{
+		if (header_size != 4)
+			{
+			fprintf(stderr, "%s: truncated buffer\n", path);
+			return 1;
+			}
+
+		size =	(zusize)header[0]	| (zusize)header[1] << 8 |
+			(zusize)header[2] << 16 | (zusize)header[3] << 24;
+
+		if (size > buffer_size)
+			{
+			zuint8 *new_buffer = realloc(buffer, size);
+
+			if (new_buffer == NULL)
+				{
+				fprintf(stderr, "Out of memory\n");
+				return 1;
+				}
+
+			buffer	    = new_buffer;
+			buffer_size = size;
+			}
+
+		if (fread(buffer, 1, size, file) != size)
+			{
+			fprintf(stderr, "%s: truncated buffer\n", path);
+			return 1;
+			}
+
+		memset(&record, 0, sizeof(M6502TraceRecord));
+
+		for (offset = 0; offset < size; offset += record_size)
+			{
+			if (!(record_size = m6502_trace_decode(&record, buffer + offset, size - offset)))
+				{
+				fprintf(stderr, "%s: incomplete record\n", path);
+				return 1;
+				}
+
+			if (record.pc >= first && record.pc <= last)
+				print_record(&record);
+			}
+		}
+
+	if (file != stdin) fclose(file);
+	free(buffer);
+	return 0;
+	}
+
+/* trace-6502.c EOF */